@@ -0,0 +1,50 @@
+// Per-thread command lists
+// A worker thread records draws (bind program/VAO/textures, set uniforms, draw) as
+// DrawRecords whose uniform payloads, like the records themselves, live in that thread's
+// sub-arena of a FrameArena, without any GL call or heap allocation.
+// The GL thread then merges every list into a RenderQueue and replays it.
+#pragma once
+
+#include "FrameArena.h"
+#include "RenderQueue.h"
+
+struct CommandList
+{
+    FrameArena* arena = NULL;
+    int thread = 0; // sub-arena of the recording thread
+    DrawRecord* draws = NULL;
+    size_t drawCount = 0, drawCapacity = 0;
+};
+
+// Call on the GL thread, after BeginArenaFrame, before handing the list to worker thread.
+// maxDraws records are reserved up front; uniform payloads are allocated while recording.
+inline void ResetCommandList(CommandList& list, FrameArena& arena, int thread, size_t maxDraws)
+{
+    list.arena = &arena;
+    list.thread = thread;
+    list.draws = ArenaAllocArray<DrawRecord>(arena, maxDraws, thread);
+    list.drawCount = 0;
+    list.drawCapacity = list.draws ? maxDraws : 0;
+}
+
+// Returns room for floats uniform values, or NULL if the arena is exhausted.
+inline float* CommandUniformAlloc(CommandList& list, size_t floats)
+{
+    return ArenaAllocArray<float>(*list.arena, floats, list.thread);
+}
+
+// false (and the draw is dropped) once the reserved records are used up.
+inline bool RecordDraw(CommandList& list, const DrawRecord& record)
+{
+    if (list.drawCount == list.drawCapacity)
+        return false;
+    list.draws[list.drawCount++] = record;
+    return true;
+}
+
+// GL thread: append every recorded list, in list order, to the queue.
+inline void MergeCommandLists(RenderQueue& queue, const CommandList* lists, int listCount)
+{
+    for (int i = 0; i < listCount; i++)
+        queue.records.insert(queue.records.end(), lists[i].draws, lists[i].draws + lists[i].drawCount);
+}
@@ -0,0 +1,234 @@
+// Damage tracking for on-demand rendering
+// A demo whose picture only changes on input keeps its last frame in a RetainedFrame, marks
+// the window rectangles a change touches (in GL window coordinates, y up) and redraws just
+// those with the scissor test before presenting. Between changes it blocks in
+// glfwWaitEvents* instead of redrawing. RenderLoad measures the cost: process CPU time
+// over wall time and frames per minute, split into idle seconds and seconds with input.
+#pragma once
+
+#include "GL/glew.h"
+#include "GLTracker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+const int kMaxDirtyRects = 8; // beyond this the rects are merged into their bounds
+
+struct DirtyRect
+{
+    int x, y, width, height;
+};
+
+struct DirtyRegion
+{
+    int windowWidth = 0, windowHeight = 0;
+    std::vector<DirtyRect> rects;
+
+    // statistics
+    unsigned long long pixelsRedrawn = 0;
+    unsigned long long pixelsFull = 0; // what full redraws of the same frames would have cost
+};
+
+inline bool DirtyRectsOverlap(const DirtyRect& a, const DirtyRect& b)
+{
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+inline DirtyRect DirtyRectUnion(const DirtyRect& a, const DirtyRect& b)
+{
+    int x0 = std::min(a.x, b.x), y0 = std::min(a.y, b.y);
+    int x1 = std::max(a.x + a.width, b.x + b.width), y1 = std::max(a.y + a.height, b.y + b.height);
+    return { x0, y0, x1 - x0, y1 - y0 };
+}
+
+// Adds a rectangle, clipped to the window; overlapping rects are merged so no pixel is drawn twice.
+inline void MarkDirty(DirtyRegion& region, DirtyRect rect)
+{
+    int x0 = std::max(rect.x, 0), y0 = std::max(rect.y, 0);
+    int x1 = std::min(rect.x + rect.width, region.windowWidth);
+    int y1 = std::min(rect.y + rect.height, region.windowHeight);
+    if (x1 <= x0 || y1 <= y0)
+        return;
+    rect = { x0, y0, x1 - x0, y1 - y0 };
+
+    for (size_t i = 0; i < region.rects.size();)
+    {
+        if (DirtyRectsOverlap(rect, region.rects[i]))
+        {
+            rect = DirtyRectUnion(rect, region.rects[i]);
+            region.rects.erase(region.rects.begin() + i);
+            i = 0; // the grown rect may now overlap one already checked
+        }
+        else
+            i++;
+    }
+    region.rects.push_back(rect);
+    if ((int)region.rects.size() > kMaxDirtyRects)
+    {
+        DirtyRect bounds = region.rects[0];
+        for (const DirtyRect& r : region.rects)
+            bounds = DirtyRectUnion(bounds, r);
+        region.rects.assign(1, bounds);
+    }
+}
+
+inline void MarkAllDirty(DirtyRegion& region)
+{
+    region.rects.assign(1, { 0, 0, region.windowWidth, region.windowHeight });
+}
+
+inline bool IsDirty(const DirtyRegion& region)
+{
+    return !region.rects.empty();
+}
+
+// Call after the dirty rects have been redrawn and presented.
+inline void ClearDirty(DirtyRegion& region)
+{
+    for (const DirtyRect& r : region.rects)
+        region.pixelsRedrawn += (unsigned long long)r.width * r.height;
+    region.pixelsFull += (unsigned long long)region.windowWidth * region.windowHeight;
+    region.rects.clear();
+}
+
+// The back buffer is undefined after a swap, so the frame lives in an offscreen color buffer
+// that only the dirty rects are redrawn into, and is blitted whole to the window to present.
+struct RetainedFrame
+{
+    int width = 0, height = 0;
+    unsigned int fbo = 0, colorBuffer = 0;
+};
+
+inline bool InitRetainedFrame(RetainedFrame& frame, int width, int height)
+{
+    frame.width = width;
+    frame.height = height;
+    glGenRenderbuffers(1, &frame.colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, frame.colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenFramebuffers(1, &frame.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, frame.fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, frame.colorBuffer);
+    GL_TRACK(GL_RENDERBUFFER, frame.colorBuffer, "retained frame", GLImageBytes(GL_RGBA8, width, height, false));
+    GL_TRACK(GL_FRAMEBUFFER, frame.fbo, "retained frame", 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete)
+    {
+        fprintf(stderr, "ERROR: retained frame framebuffer is incomplete\n");
+        return false;
+    }
+    return true;
+}
+
+// Binds the retained frame with the scissor test on; set each dirty rect with ScissorDirtyRect.
+inline void BeginDirtyRedraw(RetainedFrame& frame)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, frame.fbo);
+    glViewport(0, 0, frame.width, frame.height);
+    glEnable(GL_SCISSOR_TEST);
+}
+
+inline void ScissorDirtyRect(const DirtyRect& rect)
+{
+    glScissor(rect.x, rect.y, rect.width, rect.height);
+}
+
+// Copies the whole retained frame to the default framebuffer, ready for glfwSwapBuffers.
+inline void PresentRetainedFrame(RetainedFrame& frame)
+{
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, frame.fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, frame.width, frame.height, 0, 0, frame.width, frame.height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+inline void DestroyRetainedFrame(RetainedFrame& frame)
+{
+    DeleteGLObjects(GL_FRAMEBUFFER, 1, &frame.fbo);
+    DeleteGLObjects(GL_RENDERBUFFER, 1, &frame.colorBuffer);
+}
+
+// User + system CPU time of the whole process. Not std::clock(): the MSVC one is wall time.
+inline double ProcessCpuSeconds()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        return 0.0;
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (double)(k.QuadPart + u.QuadPart) * 1e-7; // 100 ns units
+#else
+    timespec t;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t) != 0)
+        return 0.0;
+    return (double)t.tv_sec + t.tv_nsec * 1e-9;
+#endif
+}
+
+// CPU and frame accounting in buckets of about a second; a bucket that saw any input counts
+// as interactive, the others as idle.
+struct RenderLoad
+{
+    std::chrono::steady_clock::time_point bucketStart;
+    double bucketCpu = 0.0; // ProcessCpuSeconds
+    unsigned int bucketFrames = 0;
+    bool bucketInput = false;
+
+    double seconds[2] = {}, cpuSeconds[2] = {}; // [0] idle, [1] interactive
+    unsigned long long frames[2] = {};
+};
+
+inline void InitRenderLoad(RenderLoad& load)
+{
+    load.bucketStart = std::chrono::steady_clock::now();
+    load.bucketCpu = ProcessCpuSeconds();
+}
+
+// Once per loop iteration: input = an input event arrived, rendered = a frame was presented.
+inline void CountRenderLoad(RenderLoad& load, bool input, bool rendered)
+{
+    load.bucketInput |= input;
+    if (rendered)
+        load.bucketFrames++;
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - load.bucketStart).count();
+    if (seconds < 1.0)
+        return;
+    double cpu = ProcessCpuSeconds();
+    int kind = load.bucketInput ? 1 : 0;
+    load.seconds[kind] += seconds;
+    load.cpuSeconds[kind] += cpu - load.bucketCpu;
+    load.frames[kind] += load.bucketFrames;
+    load.bucketStart = now;
+    load.bucketCpu = cpu;
+    load.bucketFrames = 0;
+    load.bucketInput = false;
+}
+
+inline void PrintRenderLoad(const RenderLoad& load, const char* name)
+{
+    const char* kinds[2] = { "idle", "interactive" };
+    for (int kind = 0; kind < 2; kind++)
+    {
+        if (load.seconds[kind] <= 0.0)
+            continue;
+        printf("%s %-11s %7.1f s, CPU %5.1f%%, %8.1f frames/min\n", name, kinds[kind], load.seconds[kind],
+               100.0 * load.cpuSeconds[kind] / load.seconds[kind], 60.0 * load.frames[kind] / load.seconds[kind]);
+    }
+}
@@ -0,0 +1,65 @@
+// Per-event and per-frame CPU kernels of the demos
+// Pulled out of the demos so microbench.cpp can time the very code they run without a GL
+// context. Nothing here touches GL; the model matrix builders need glm and are only declared
+// when glm has been included first.
+#pragma once
+
+#include <random>
+
+// square: window pixels (y down) to [-1, 1] (y up), as cursor_pos_callback sees the cursor.
+inline void CursorToClip(double x, double y, int width, int height, float& clipX, float& clipY)
+{
+    clipX = (2.0f * x) / width - 1.0f;
+    clipY = 1.0f - (2.0f * y) / height;
+}
+
+// square: is (clipX, clipY) on the square of half size `half` centred at (centerX, centerY)?
+// Both axes are scaled by xmax, as the demo has always done.
+inline bool SquareHit(float clipX, float clipY, float centerX, float centerY, float half, float xmax)
+{
+    return clipX >= (centerX - half) / xmax && clipX <= (centerX + half) / xmax &&
+           clipY >= (centerY - half) / xmax && clipY <= (centerY + half) / xmax;
+}
+
+// Snow: the falling flake, in the rectangle's coordinates.
+struct Flake
+{
+    float x, y, radius;
+};
+
+// One frame of the flake inside a rectangle of half size halfWidth x halfHeight centred at
+// rectangleX: falls, respawns at the top with a random x and radius once it reaches the
+// bottom, and wraps around the sides. Draws from gen in the order the --replay logs expect.
+inline void StepFlake(Flake& flake, float rectangleX, float halfWidth, float halfHeight, std::mt19937& gen)
+{
+    flake.y -= 0.001f;
+    if (flake.y <= -halfHeight + flake.radius)
+    {
+        flake.y = halfHeight;
+        std::uniform_real_distribution<float> offsetDistribution(-halfWidth, halfWidth);
+        flake.x = rectangleX + offsetDistribution(gen);
+        std::uniform_real_distribution<float> radiusDistribution(0.02f, 0.2f);
+        flake.radius = radiusDistribution(gen);
+    }
+
+    if (flake.x >= rectangleX + halfWidth)
+        flake.x = rectangleX - halfWidth;
+    else if (flake.x <= rectangleX - halfWidth)
+        flake.x = rectangleX + halfWidth;
+}
+
+#ifdef GLM_VERSION
+// plevra: the quad tilted by angle degrees about (1, 0, 1).
+inline glm::mat4 QuadModelMatrix(float angle)
+{
+    return glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(1.0f, 0.0f, 1.0f));
+}
+
+// opencube: one cube of the grid, moved to position, shrunk to its cell and spun by angle degrees.
+inline glm::mat4 CubeModelMatrix(const glm::vec3& position, float cellScale, float angle)
+{
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+    model = glm::scale(model, glm::vec3(cellScale));
+    return glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 1.0f, 1.0f));
+}
+#endif
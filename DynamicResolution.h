@@ -0,0 +1,195 @@
+// Dynamic resolution
+//   --dynres MS [log.csv]   render at whatever scale keeps the scene's GPU time near MS
+// The scene draws into the lower-left corner of an offscreen target sized for the full
+// window, at scale * window size, and EndDynamicResolution stretches that corner over the
+// window with a bilinear blit. The GPU time of every frame is read back a few frames later
+// (GL_TIME_ELAPSED); every kDynResInterval frames the average decides the next scale:
+//   average > target * kDynResOverBudget   shrink at once, by the pixel ratio target / average
+//   average < target * kDynResHeadroom     grow by one kDynResStep
+// Between the two thresholds the scale holds, so it does not oscillate around the target.
+#pragma once
+
+#include "GL/glew.h"
+#include "GLTracker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+const int kDynResQueries = 4;      // frames in flight before a timer result is read
+const int kDynResInterval = 8;     // frames averaged per decision
+const float kDynResOverBudget = 1.05f;
+const float kDynResHeadroom = 0.75f;
+const float kDynResStep = 0.05f;
+
+struct DynamicResolution
+{
+    bool enabled = false;
+    int windowWidth = 0, windowHeight = 0;
+    float scale = 1.0f, minScale = 0.25f, maxScale = 1.0f;
+    double targetMs = 16.0;
+
+    unsigned int fbo = 0, colorTexture = 0, depthBuffer = 0;
+    unsigned int queries[kDynResQueries] = {};
+    float queryScale[kDynResQueries] = {}; // scale the query's frame was drawn at
+    bool queryPending[kDynResQueries] = {};
+    unsigned int frame = 0;
+
+    // current decision window
+    double gpuMsSum = 0.0;
+    int samples = 0;
+    int changes = 0;
+
+    FILE* log = NULL;
+    std::chrono::steady_clock::time_point lastFrame;
+};
+
+inline int DynamicWidth(const DynamicResolution& dr)
+{
+    return std::max(1, (int)(dr.windowWidth * dr.scale + 0.5f));
+}
+
+inline int DynamicHeight(const DynamicResolution& dr)
+{
+    return std::max(1, (int)(dr.windowHeight * dr.scale + 0.5f));
+}
+
+inline bool InitDynamicResolution(DynamicResolution& dr, int width, int height, double targetMs,
+                                  const char* logPath = NULL)
+{
+    dr.windowWidth = width;
+    dr.windowHeight = height;
+    dr.targetMs = targetMs;
+
+    // allocated once at full size; lower scales use a corner of it, so changing scale is free
+    glGenTextures(1, &dr.colorTexture);
+    glBindTexture(GL_TEXTURE_2D, dr.colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glGenRenderbuffers(1, &dr.depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, dr.depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+    glGenFramebuffers(1, &dr.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, dr.fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, dr.colorTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, dr.depthBuffer);
+    GL_TRACK(GL_TEXTURE, dr.colorTexture, "dynamic resolution color", GLImageBytes(GL_RGBA8, width, height, false));
+    GL_TRACK(GL_RENDERBUFFER, dr.depthBuffer, "dynamic resolution depth",
+             GLImageBytes(GL_DEPTH_COMPONENT24, width, height, false));
+    GL_TRACK(GL_FRAMEBUFFER, dr.fbo, "dynamic resolution", 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete)
+    {
+        fprintf(stderr, "ERROR: dynamic resolution framebuffer is incomplete\n");
+        return false;
+    }
+
+    glGenQueries(kDynResQueries, dr.queries);
+    TrackGLObjects(GL_QUERY, kDynResQueries, dr.queries, "dynamic resolution timer", 0, __FILE__, __LINE__);
+    if (logPath)
+    {
+        dr.log = fopen(logPath, "w");
+        if (dr.log)
+            fprintf(dr.log, "frame,scale,width,height,cpu_ms,gpu_frame,gpu_ms\n");
+    }
+    dr.lastFrame = std::chrono::steady_clock::now();
+    dr.enabled = true;
+    return true;
+}
+
+// Redirects the scene into the offscreen target at the current scale.
+inline void BeginDynamicResolution(DynamicResolution& dr)
+{
+    int slot = dr.frame % kDynResQueries;
+    glBindFramebuffer(GL_FRAMEBUFFER, dr.fbo);
+    glViewport(0, 0, DynamicWidth(dr), DynamicHeight(dr));
+    glBeginQuery(GL_TIME_ELAPSED, dr.queries[slot]);
+    dr.queryScale[slot] = dr.scale;
+}
+
+// Folds one finished GPU time into the window and, at the end of a window, picks the next scale.
+inline void UpdateDynamicScale(DynamicResolution& dr, double gpuMs)
+{
+    dr.gpuMsSum += gpuMs;
+    if (++dr.samples < kDynResInterval)
+        return;
+    double average = dr.gpuMsSum / dr.samples;
+    dr.gpuMsSum = 0.0;
+    dr.samples = 0;
+
+    float scale = dr.scale;
+    if (average > dr.targetMs * kDynResOverBudget)
+        scale = dr.scale * (float)std::sqrt(dr.targetMs / average); // cost follows the pixel count
+    else if (average < dr.targetMs * kDynResHeadroom)
+        scale = dr.scale + kDynResStep;
+    scale = std::min(dr.maxScale, std::max(dr.minScale, scale));
+    if (std::fabs(scale - dr.scale) > 0.001f)
+    {
+        dr.scale = scale;
+        dr.changes++;
+    }
+}
+
+// Upscales to the default framebuffer, and feeds the timer results that are ready to the controller.
+inline void EndDynamicResolution(DynamicResolution& dr)
+{
+    glEndQuery(GL_TIME_ELAPSED);
+
+    int width = DynamicWidth(dr), height = DynamicHeight(dr);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, dr.fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, dr.windowWidth, dr.windowHeight,
+                      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, dr.windowWidth, dr.windowHeight);
+    float drawnScale = dr.scale;
+    dr.queryPending[dr.frame % kDynResQueries] = true;
+    dr.frame++;
+
+    // the oldest query in the ring; frames drawn at an older scale do not count
+    int slot = dr.frame % kDynResQueries;
+    double gpuMs = -1.0; // -1: no result this frame
+    unsigned int gpuFrame = dr.frame - kDynResQueries;
+    if (dr.queryPending[slot])
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(dr.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(dr.queries[slot], GL_QUERY_RESULT, &ns);
+            dr.queryPending[slot] = false;
+            gpuMs = ns / 1e6;
+            if (dr.queryScale[slot] == dr.scale)
+                UpdateDynamicScale(dr, gpuMs);
+        }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    double cpuMs = std::chrono::duration<double, std::milli>(now - dr.lastFrame).count();
+    dr.lastFrame = now;
+    if (dr.log)
+        fprintf(dr.log, "%u,%.3f,%d,%d,%.4f,%u,%.4f\n", dr.frame - 1, drawnScale, width, height, cpuMs,
+                gpuMs >= 0.0 ? gpuFrame : 0, gpuMs);
+}
+
+inline void DestroyDynamicResolution(DynamicResolution& dr)
+{
+    if (!dr.enabled)
+        return;
+    printf("Dynamic resolution: target %.2f ms, final scale %.2f (%dx%d), %d scale changes over %u frames\n",
+           dr.targetMs, dr.scale, DynamicWidth(dr), DynamicHeight(dr), dr.changes, dr.frame);
+    if (dr.log)
+        fclose(dr.log);
+    dr.log = NULL;
+    DeleteGLObjects(GL_QUERY, kDynResQueries, dr.queries);
+    DeleteGLObjects(GL_FRAMEBUFFER, 1, &dr.fbo);
+    DeleteGLObjects(GL_RENDERBUFFER, 1, &dr.depthBuffer);
+    DeleteGLObjects(GL_TEXTURE, 1, &dr.colorTexture);
+    dr.enabled = false;
+}
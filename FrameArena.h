@@ -0,0 +1,224 @@
+// Per-frame linear (bump) allocator
+// Transient frame data (matrices, uniform payloads, command records, sort scratch) is carved
+// out of one block allocated up front instead of coming from the heap. BeginArenaFrame moves
+// to the next of kFrameArenaFrames frame slots and resets it in O(threads), so memory handed
+// out in frame N stays valid while frame N + 1 is built (it can still read last frame's data)
+// and is reused in frame N + kFrameArenaFrames. Each frame slot is split into one sub-arena
+// per thread, so worker threads allocate without locks; thread 0 is the GL thread.
+//
+// The heap check counts every operator new of the program (define FRAME_ARENA_HEAP_COUNTER in
+// exactly one translation unit before including this header) and reports any frame after a
+// warm-up that still allocated: in steady state a frame should make no heap allocations.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+const int kFrameArenaFrames = 2;
+const size_t kFrameArenaAlignment = 16; // default alignment: enough for glm types and SSE
+
+struct FrameArenaSlot
+{
+    unsigned char* base = NULL;
+    size_t capacity = 0, used = 0;
+};
+
+struct FrameArena
+{
+    std::unique_ptr<unsigned char[]> memory;
+    std::vector<FrameArenaSlot> slots; // frames x threads
+    int frames = 0, threads = 0;
+    int current = 0;
+
+    // statistics
+    unsigned long long frameCount = 0;
+    size_t lastFrameBytes = 0;  // high-water mark of the last finished frame, all threads
+    size_t peakFrameBytes = 0;
+    unsigned long long peakFrame = 0;
+    std::vector<size_t> peakThreadBytes;
+    std::atomic<unsigned long long> failed{ 0 }; // allocations that did not fit, from any thread
+};
+
+// bytesPerThread: the most one thread allocates in one frame.
+inline void InitFrameArena(FrameArena& arena, size_t bytesPerThread, int threads = 1, int frames = kFrameArenaFrames)
+{
+    bytesPerThread = (bytesPerThread + 63) / 64 * 64; // sub-arenas on their own cache lines
+    arena.frames = frames;
+    arena.threads = threads;
+    arena.memory.reset(new unsigned char[bytesPerThread * threads * frames + 64]);
+    unsigned char* base = (unsigned char*)(((uintptr_t)arena.memory.get() + 63) & ~(uintptr_t)63);
+    arena.slots.resize((size_t)threads * frames);
+    for (size_t i = 0; i < arena.slots.size(); i++)
+    {
+        arena.slots[i].base = base + i * bytesPerThread;
+        arena.slots[i].capacity = bytesPerThread;
+        arena.slots[i].used = 0;
+    }
+    arena.peakThreadBytes.assign(threads, 0);
+    arena.current = 0;
+}
+
+inline FrameArenaSlot& FrameArenaThread(FrameArena& arena, int thread)
+{
+    return arena.slots[(size_t)arena.current * arena.threads + thread];
+}
+
+// Closes the statistics of the frame just built and resets the oldest frame slot for the next.
+// Call on the GL thread while no worker is allocating.
+inline void BeginArenaFrame(FrameArena& arena)
+{
+    if (arena.frameCount > 0)
+    {
+        size_t bytes = 0;
+        for (int thread = 0; thread < arena.threads; thread++)
+        {
+            size_t used = FrameArenaThread(arena, thread).used;
+            bytes += used;
+            if (used > arena.peakThreadBytes[thread])
+                arena.peakThreadBytes[thread] = used;
+        }
+        arena.lastFrameBytes = bytes;
+        if (bytes > arena.peakFrameBytes)
+        {
+            arena.peakFrameBytes = bytes;
+            arena.peakFrame = arena.frameCount;
+        }
+    }
+    arena.frameCount++;
+    arena.current = (arena.current + 1) % arena.frames;
+    for (int thread = 0; thread < arena.threads; thread++)
+        FrameArenaThread(arena, thread).used = 0;
+}
+
+// Returns bytes from this frame's sub-arena of thread, or NULL if it is exhausted
+// (the caller skips the work, as with StreamAlloc). alignment must be a power of two.
+inline void* ArenaAlloc(FrameArena& arena, size_t bytes, size_t alignment = kFrameArenaAlignment, int thread = 0)
+{
+    FrameArenaSlot& slot = FrameArenaThread(arena, thread);
+    size_t start = (slot.used + alignment - 1) & ~(alignment - 1);
+    if (start + bytes > slot.capacity)
+    {
+        arena.failed.fetch_add(1, std::memory_order_relaxed);
+        return NULL;
+    }
+    slot.used = start + bytes;
+    return slot.base + start;
+}
+
+// count uninitialized Ts (trivially copyable data only: nothing is ever destroyed).
+template <typename T>
+inline T* ArenaAllocArray(FrameArena& arena, size_t count, int thread = 0)
+{
+    size_t alignment = alignof(T) > kFrameArenaAlignment ? alignof(T) : kFrameArenaAlignment;
+    return (T*)ArenaAlloc(arena, count * sizeof(T), alignment, thread);
+}
+
+inline void PrintFrameArenaStats(const FrameArena& arena, const char* name)
+{
+    size_t capacity = arena.slots.empty() ? 0 : arena.slots[0].capacity;
+    printf("%s arena: %d frames x %d threads x %.1f KB, last frame %.1f KB, high water %.1f KB (frame %llu)",
+           name, arena.frames, arena.threads, capacity / 1024.0, arena.lastFrameBytes / 1024.0,
+           arena.peakFrameBytes / 1024.0, arena.peakFrame);
+    if (arena.threads > 1)
+    {
+        printf(", per thread");
+        for (size_t bytes : arena.peakThreadBytes)
+            printf(" %.1f", bytes / 1024.0);
+        printf(" KB");
+    }
+    if (arena.failed)
+        printf(", %llu allocations did not fit", arena.failed.load());
+    printf("\n");
+}
+
+// --heap-check
+inline std::atomic<unsigned long long> heapAllocations{ 0 };
+
+struct HeapCheck
+{
+    bool enabled = false;
+    unsigned long long warmupFrames = 0;
+    unsigned long long frames = 0, lastCount = 0;
+    unsigned long long steadyFrames = 0, dirtyFrames = 0, steadyAllocations = 0;
+};
+
+inline HeapCheck heapCheck;
+
+// Frames before warmupFrames may allocate (lazy driver and container growth).
+inline void BeginHeapCheck(unsigned long long warmupFrames = 120)
+{
+    heapCheck.enabled = true;
+    heapCheck.warmupFrames = warmupFrames;
+    heapCheck.lastCount = heapAllocations.load(std::memory_order_relaxed);
+}
+
+// Once per frame, after it was presented.
+inline void CountFrameHeap()
+{
+    if (!heapCheck.enabled)
+        return;
+    unsigned long long count = heapAllocations.load(std::memory_order_relaxed);
+    unsigned long long allocations = count - heapCheck.lastCount;
+    heapCheck.lastCount = count;
+    if (++heapCheck.frames <= heapCheck.warmupFrames)
+        return;
+    heapCheck.steadyFrames++;
+    if (allocations == 0)
+        return;
+    if (heapCheck.dirtyFrames++ < 10)
+        fprintf(stderr, "ERROR: frame %llu made %llu heap allocations\n", heapCheck.frames, allocations);
+    heapCheck.steadyAllocations += allocations;
+}
+
+// Prints the verdict; false if a steady-state frame allocated.
+inline bool EndHeapCheck()
+{
+    if (!heapCheck.enabled)
+        return true;
+    printf("heap check: %llu steady-state frames after %llu warm-up, %llu heap allocations in %llu frames\n",
+           heapCheck.steadyFrames, heapCheck.warmupFrames, heapCheck.steadyAllocations, heapCheck.dirtyFrames);
+    return heapCheck.dirtyFrames == 0;
+}
+
+#ifdef FRAME_ARENA_HEAP_COUNTER
+// Replaces the global allocation functions: count, then malloc. Over-aligned allocations keep
+// the library versions and are not counted.
+void* operator new(size_t size)
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
+#endif
@@ -0,0 +1,303 @@
+// Asynchronous frame capture
+//   --capture out.y4m          one Y4M video (4:4:4, BT.601), playable with ffplay/mpv
+//   --capture frames/%05d.ppm  one binary PPM per frame (the pattern takes exactly one integer: the frame number)
+// CaptureFrame reads the back buffer into one of a ring of pixel-pack buffers and places a
+// fence. The buffer is mapped a few frames later, once its fence has signaled, and copied into
+// a queue that a writer thread drains to disk, so neither glReadPixels nor the disk stalls
+// the frame. A stall is counted when the ring wraps before a fence has signaled, a drop when
+// the writer falls more than kCaptureQueueDepth frames behind.
+#pragma once
+
+#include "GL/glew.h"
+#include "GLTracker.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+const int kMaxCaptureSlots = 8;
+const size_t kCaptureQueueDepth = 16;
+
+struct CapturedFrame
+{
+    unsigned int index;
+    std::vector<unsigned char> rgba; // bottom-up, as GL returns it
+};
+
+struct FrameCapture
+{
+    bool enabled = false;
+    const char* path = NULL;
+    bool y4m = false;
+    int width = 0, height = 0;
+
+    int slotCount = 3;
+    unsigned int pbo[kMaxCaptureSlots] = {};
+    GLsync fence[kMaxCaptureSlots] = {};
+    unsigned int slotFrame[kMaxCaptureSlots] = {};
+    unsigned int frame = 0;
+
+    // writer thread
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<CapturedFrame> queue;
+    std::vector<std::vector<unsigned char>> freeBuffers; // recycled so steady state does not allocate
+    bool stopping = false;
+    FILE* video = NULL;
+
+    unsigned int captured = 0, written = 0, stalls = 0, dropped = 0;
+    double stallMs = 0.0;
+};
+
+// BT.601 studio range, what Y4M players assume
+inline void RgbToYuv(const unsigned char* p, unsigned char& y, unsigned char& u, unsigned char& v)
+{
+    int r = p[0], g = p[1], b = p[2];
+    y = (unsigned char)((66 * r + 129 * g + 25 * b + 128) / 256 + 16);
+    u = (unsigned char)((-38 * r - 74 * g + 112 * b + 128) / 256 + 128);
+    v = (unsigned char)((112 * r - 94 * g - 18 * b + 128) / 256 + 128);
+}
+
+// Writer thread side: one frame to disk, flipped to top-down.
+inline void WriteCapturedFrame(FrameCapture& cap, const CapturedFrame& frame, std::vector<unsigned char>& row)
+{
+    int w = cap.width, h = cap.height;
+    if (cap.y4m)
+    {
+        // planar Y, U, V
+        row.resize((size_t)w * h * 3);
+        unsigned char* planeY = row.data();
+        unsigned char* planeU = planeY + (size_t)w * h;
+        unsigned char* planeV = planeU + (size_t)w * h;
+        for (int y = 0; y < h; y++)
+        {
+            const unsigned char* src = frame.rgba.data() + (size_t)(h - 1 - y) * w * 4;
+            for (int x = 0; x < w; x++)
+            {
+                size_t i = (size_t)y * w + x;
+                RgbToYuv(src + x * 4, planeY[i], planeU[i], planeV[i]);
+            }
+        }
+        fputs("FRAME\n", cap.video);
+        fwrite(row.data(), 1, row.size(), cap.video);
+        return;
+    }
+
+    char name[512];
+    snprintf(name, sizeof(name), cap.path, frame.index);
+    FILE* file = fopen(name, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "ERROR: could not write capture %s\n", name);
+        return;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", w, h);
+    row.resize((size_t)w * 3);
+    for (int y = h - 1; y >= 0; y--)
+    {
+        const unsigned char* src = frame.rgba.data() + (size_t)y * w * 4;
+        for (int x = 0; x < w; x++)
+            memcpy(&row[x * 3], src + x * 4, 3);
+        fwrite(row.data(), 1, row.size(), file);
+    }
+    fclose(file);
+}
+
+inline void CaptureWriterLoop(FrameCapture* cap)
+{
+    std::vector<unsigned char> row;
+    for (;;)
+    {
+        CapturedFrame frame;
+        {
+            std::unique_lock<std::mutex> lock(cap->mutex);
+            cap->wake.wait(lock, [cap] { return cap->stopping || !cap->queue.empty(); });
+            if (cap->queue.empty())
+                return; // stopping and drained
+            frame = std::move(cap->queue.front());
+            cap->queue.pop_front();
+        }
+        WriteCapturedFrame(*cap, frame, row);
+        std::lock_guard<std::mutex> lock(cap->mutex);
+        cap->written++;
+        cap->freeBuffers.push_back(std::move(frame.rgba));
+    }
+}
+
+// A PPM pattern is handed to snprintf with the frame number only: it must hold exactly one
+// integer conversion (flags and width allowed, e.g. %05d) and no other conversion but %%.
+inline bool CapturePatternValid(const char* pattern)
+{
+    int conversions = 0;
+    for (const char* p = pattern; *p; p++)
+    {
+        if (*p != '%')
+            continue;
+        if (*++p == '%')
+            continue;
+        while (*p && strchr("-+ #0", *p))
+            p++;
+        while (*p >= '0' && *p <= '9')
+            p++;
+        if (!*p || !strchr("diuxXo", *p))
+            return false;
+        conversions++;
+    }
+    return conversions == 1;
+}
+
+// Path ending in .y4m writes a video, anything else is a printf pattern for PPM files.
+inline bool InitFrameCapture(FrameCapture& cap, const char* path, int width, int height, int slots = 3)
+{
+    cap.path = path;
+    cap.width = width;
+    cap.height = height;
+    cap.slotCount = slots < 2 ? 2 : (slots > kMaxCaptureSlots ? kMaxCaptureSlots : slots);
+    size_t length = strlen(path);
+    cap.y4m = length > 4 && strcmp(path + length - 4, ".y4m") == 0;
+    if (cap.y4m)
+    {
+        cap.video = fopen(path, "wb");
+        if (!cap.video)
+        {
+            fprintf(stderr, "ERROR: could not write capture %s\n", path);
+            return false;
+        }
+        fprintf(cap.video, "YUV4MPEG2 W%d H%d F60:1 Ip A1:1 C444\n", width, height);
+    }
+    else if (!CapturePatternValid(path))
+    {
+        fprintf(stderr, "ERROR: capture path %s needs exactly one frame number conversion such as %%05d "
+                        "(write %%%% for a literal %%)\n", path);
+        return false;
+    }
+
+    glGenBuffers(cap.slotCount, cap.pbo);
+    for (int i = 0; i < cap.slotCount; i++)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, cap.pbo[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (size_t)width * height * 4, NULL, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    TrackGLObjects(GL_BUFFER, cap.slotCount, cap.pbo, "capture readback", (size_t)width * height * 4, __FILE__,
+                   __LINE__);
+
+    cap.enabled = true;
+    cap.stopping = false;
+    cap.writer = std::thread(CaptureWriterLoop, &cap);
+    return true;
+}
+
+// Maps a finished slot and queues its pixels for the writer (or drops them if it is behind).
+inline void CollectCaptureSlot(FrameCapture& cap, int slot)
+{
+    glDeleteSync(cap.fence[slot]);
+    cap.fence[slot] = NULL;
+
+    std::vector<unsigned char> rgba;
+    {
+        std::lock_guard<std::mutex> lock(cap.mutex);
+        if (cap.queue.size() >= kCaptureQueueDepth)
+        {
+            cap.dropped++;
+            return;
+        }
+        if (!cap.freeBuffers.empty())
+        {
+            rgba = std::move(cap.freeBuffers.back());
+            cap.freeBuffers.pop_back();
+        }
+    }
+
+    size_t size = (size_t)cap.width * cap.height * 4;
+    rgba.resize(size);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, cap.pbo[slot]);
+    void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if (pixels)
+    {
+        memcpy(rgba.data(), pixels, size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    {
+        std::lock_guard<std::mutex> lock(cap.mutex);
+        cap.queue.push_back({ cap.slotFrame[slot], std::move(rgba) });
+    }
+    cap.wake.notify_one();
+    cap.captured++;
+}
+
+// Call after the frame is drawn and before glfwSwapBuffers.
+inline void CaptureFrame(FrameCapture& cap)
+{
+    if (!cap.enabled)
+        return;
+
+    // collect, oldest first, every read that has already landed, without waiting
+    // (fences signal in order, so the first pending one ends the scan)
+    for (int n = 0; n < cap.slotCount; n++)
+    {
+        int i = (cap.frame + n) % cap.slotCount;
+        if (!cap.fence[i])
+            continue;
+        if (glClientWaitSync(cap.fence[i], 0, 0) == GL_TIMEOUT_EXPIRED)
+            break;
+        CollectCaptureSlot(cap, i);
+    }
+
+    // the ring wrapped before the GPU finished this slot: wait for it
+    int slot = cap.frame % cap.slotCount;
+    if (cap.fence[slot])
+    {
+        auto start = std::chrono::steady_clock::now();
+        glClientWaitSync(cap.fence[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        cap.stallMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        cap.stalls++;
+        CollectCaptureSlot(cap, slot);
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, cap.pbo[slot]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadBuffer(GL_BACK);
+    glReadPixels(0, 0, cap.width, cap.height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    cap.fence[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    cap.slotFrame[slot] = cap.frame++;
+}
+
+// Waits for the reads in flight, lets the writer drain and prints the totals.
+inline void FinishFrameCapture(FrameCapture& cap)
+{
+    if (!cap.enabled)
+        return;
+    for (unsigned int n = 0; n < (unsigned int)cap.slotCount; n++)
+    {
+        int slot = (cap.frame + n) % cap.slotCount; // oldest first
+        if (cap.fence[slot])
+        {
+            glClientWaitSync(cap.fence[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            CollectCaptureSlot(cap, slot);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(cap.mutex);
+        cap.stopping = true;
+    }
+    cap.wake.notify_one();
+    cap.writer.join();
+    if (cap.video)
+        fclose(cap.video);
+    cap.video = NULL;
+    DeleteGLObjects(GL_BUFFER, cap.slotCount, cap.pbo);
+    cap.enabled = false;
+
+    printf("Capture %s: %u frames read, %u written, %u dropped, %u stalls (%.2f ms)\n", cap.path, cap.frame,
+           cap.written, cap.dropped, cap.stalls, cap.stallMs);
+}
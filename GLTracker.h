@@ -0,0 +1,162 @@
+// GL object accounting
+// Every helper that creates a GL object registers it here with its type, a label, its size
+// in bytes and the file:line that asked for it; deleting through DeleteGLObjects removes it.
+// PrintGLTotals shows what is alive right now per type, ReportGLLeaks (after the scene has
+// shut down) lists whatever is still alive. With KHR_debug the label is also given to the
+// driver (glObjectLabel), so RenderDoc / apitrace show the same names.
+// The type is the glObjectLabel identifier: GL_BUFFER, GL_TEXTURE, GL_VERTEX_ARRAY, ...
+#pragma once
+
+#include "GL/glew.h"
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <utility>
+
+// Default arguments that are evaluated at the caller (GCC, Clang, MSVC 16.6+), so a helper
+// records the line of the demo that called it rather than its own.
+#define GL_SITE_PARAMS const char* siteFile = __builtin_FILE(), int siteLine = __builtin_LINE()
+#define GL_SITE_ARGS siteFile, siteLine
+
+// Registers an object created in the current function.
+#define GL_TRACK(type, object, label, bytes) TrackGLObject(type, object, label, bytes, __FILE__, __LINE__)
+
+struct TrackedGLObject
+{
+    std::string label;
+    size_t bytes;
+    const char* file;
+    int line;
+};
+
+inline std::map<std::pair<GLenum, unsigned int>, TrackedGLObject> trackedGLObjects;
+
+inline const char* GLObjectTypeName(GLenum type)
+{
+    switch (type)
+    {
+    case GL_BUFFER: return "buffer";
+    case GL_TEXTURE: return "texture";
+    case GL_VERTEX_ARRAY: return "vertex array";
+    case GL_PROGRAM: return "program";
+    case GL_SHADER: return "shader";
+    case GL_FRAMEBUFFER: return "framebuffer";
+    case GL_RENDERBUFFER: return "renderbuffer";
+    case GL_QUERY: return "query";
+    default: return "object";
+    }
+}
+
+// Bytes of a width x height image in internalFormat, plus a third for a full mip chain.
+inline size_t GLImageBytes(GLenum internalFormat, int width, int height, bool mipmapped)
+{
+    size_t texel;
+    switch (internalFormat)
+    {
+    case GL_R8: case GL_RED: texel = 1; break;
+    case GL_RG8: case GL_R16F: texel = 2; break;
+    case GL_RGB: case GL_RGB8: // drivers pad RGB8 to 4 bytes
+    case GL_RGBA: case GL_RGBA8: case GL_R32F: case GL_RG16F:
+    case GL_DEPTH_COMPONENT24: case GL_DEPTH24_STENCIL8: texel = 4; break;
+    case GL_RGBA16F: case GL_RG32F: texel = 8; break;
+    case GL_RGBA32F: texel = 16; break;
+    default: texel = 4; break;
+    }
+    size_t bytes = (size_t)width * height * texel;
+    return mipmapped ? bytes * 4 / 3 : bytes;
+}
+
+// The object must have been bound once, or glObjectLabel rejects the name.
+inline void TrackGLObject(GLenum type, unsigned int object, const char* label, size_t bytes, const char* file, int line)
+{
+    if (object == 0)
+        return;
+    trackedGLObjects[{ type, object }] = { label, bytes, file, line };
+    if (GLEW_KHR_debug)
+        glObjectLabel(type, object, -1, label);
+}
+
+inline void TrackGLObjects(GLenum type, int count, const unsigned int* objects, const char* label, size_t bytesEach,
+                           const char* file, int line)
+{
+    for (int i = 0; i < count; i++)
+        TrackGLObject(type, objects[i], label, bytesEach, file, line);
+}
+
+// For storage that is (re)specified after creation.
+inline void SetGLObjectBytes(GLenum type, unsigned int object, size_t bytes)
+{
+    auto found = trackedGLObjects.find({ type, object });
+    if (found != trackedGLObjects.end())
+        found->second.bytes = bytes;
+}
+
+inline void UntrackGLObject(GLenum type, unsigned int object)
+{
+    trackedGLObjects.erase({ type, object });
+}
+
+// glDelete* for any tracked type.
+inline void DeleteGLObjects(GLenum type, int count, const unsigned int* objects)
+{
+    for (int i = 0; i < count; i++)
+        UntrackGLObject(type, objects[i]);
+    switch (type)
+    {
+    case GL_BUFFER: glDeleteBuffers(count, objects); break;
+    case GL_TEXTURE: glDeleteTextures(count, objects); break;
+    case GL_VERTEX_ARRAY: glDeleteVertexArrays(count, objects); break;
+    case GL_FRAMEBUFFER: glDeleteFramebuffers(count, objects); break;
+    case GL_RENDERBUFFER: glDeleteRenderbuffers(count, objects); break;
+    case GL_QUERY: glDeleteQueries(count, objects); break;
+    case GL_PROGRAM:
+        for (int i = 0; i < count; i++)
+            glDeleteProgram(objects[i]);
+        break;
+    case GL_SHADER:
+        for (int i = 0; i < count; i++)
+            glDeleteShader(objects[i]);
+        break;
+    }
+}
+
+inline size_t TrackedGLBytes()
+{
+    size_t total = 0;
+    for (const auto& entry : trackedGLObjects)
+        total += entry.second.bytes;
+    return total;
+}
+
+// Live totals, one line per type.
+inline void PrintGLTotals(const char* when)
+{
+    std::map<GLenum, std::pair<int, size_t>> perType;
+    for (const auto& entry : trackedGLObjects)
+    {
+        auto& total = perType[entry.first.first];
+        total.first++;
+        total.second += entry.second.bytes;
+    }
+    printf("GL objects %s: %zu alive, %.1f KB\n", when, trackedGLObjects.size(), TrackedGLBytes() / 1024.0);
+    for (const auto& total : perType)
+        printf("  %-13s %4d  %10.1f KB\n", GLObjectTypeName(total.first), total.second.first,
+               total.second.second / 1024.0);
+}
+
+// Call after everything should have been deleted. Returns the number of leaked objects.
+inline int ReportGLLeaks()
+{
+    if (trackedGLObjects.empty())
+    {
+        printf("GL objects: no leaks\n");
+        return 0;
+    }
+    fprintf(stderr, "GL objects: %zu leaked, %.1f KB\n", trackedGLObjects.size(), TrackedGLBytes() / 1024.0);
+    for (const auto& entry : trackedGLObjects)
+        fprintf(stderr, "  %s %u \"%s\" %zu bytes, created at %s:%d\n", GLObjectTypeName(entry.first.first),
+                entry.first.second, entry.second.label.c_str(), entry.second.bytes, entry.second.file,
+                entry.second.line);
+    return (int)trackedGLObjects.size();
+}
@@ -0,0 +1,222 @@
+// Input record / replay
+//   --record file   run live, log the RNG seed, frame times and cursor events
+//   --replay file   ignore live input and feed the logged events back frame by frame
+//   --timing file   write "frame,ms" per frame (CSV) so two builds can be diffed
+//   --headless      hidden window, no vsync (useful with --replay)
+// Log layout: InputLogHeader followed by InputEvent records (24 bytes each).
+#pragma once
+
+// the demos include GLFW from either location
+#if __has_include("GL/glfw3.h")
+#include "GL/glfw3.h"
+#else
+#include "GLFW/glfw3.h"
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+const char kInputLogMagic[4] = { 'I', 'N', 'P', '1' };
+
+enum InputMode
+{
+    INPUT_LIVE,
+    INPUT_RECORD,
+    INPUT_REPLAY
+};
+
+enum InputEventType
+{
+    INPUT_FRAME = 1,   // x = frame time in seconds
+    INPUT_CURSOR = 2,  // x, y = cursor position
+    INPUT_END = 3      // last frame of the log
+};
+
+struct InputLogHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t seed;
+};
+
+struct InputEvent
+{
+    uint32_t frame;
+    uint32_t type;
+    double x, y;
+};
+
+struct InputRecorder
+{
+    InputMode mode = INPUT_LIVE;
+    bool headless = false;
+    uint64_t seed = 0;
+    uint32_t frame = 0;
+    double frameTime = 0.0;
+
+    FILE* log = NULL;
+    std::vector<InputEvent> events; // replay
+    size_t next = 0;
+    GLFWcursorposfun cursorCallback = NULL;
+
+    FILE* timing = NULL;
+    std::chrono::steady_clock::time_point frameStart;
+};
+
+// Parses the flags above and picks the seed. Call before glfwCreateWindow.
+// Returns false if a log could not be opened.
+inline bool InitInputRecorder(InputRecorder& rec, int argc, char** argv)
+{
+    const char* recordPath = NULL;
+    const char* replayPath = NULL;
+    const char* timingPath = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            replayPath = argv[++i];
+        else if (strcmp(argv[i], "--timing") == 0 && i + 1 < argc)
+            timingPath = argv[++i];
+        else if (strcmp(argv[i], "--headless") == 0)
+            rec.headless = true;
+    }
+
+    std::random_device rd;
+    rec.seed = ((uint64_t)rd() << 32) | rd();
+
+    if (replayPath)
+    {
+        rec.mode = INPUT_REPLAY;
+        FILE* file = fopen(replayPath, "rb");
+        InputLogHeader header;
+        if (!file || fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, kInputLogMagic, 4) != 0)
+        {
+            fprintf(stderr, "ERROR: could not read input log %s\n", replayPath);
+            if (file)
+                fclose(file);
+            return false;
+        }
+        rec.seed = header.seed;
+        InputEvent event;
+        while (fread(&event, sizeof(event), 1, file) == 1)
+            rec.events.push_back(event);
+        fclose(file);
+        printf("Replaying %s: seed %llu, %zu events\n", replayPath, (unsigned long long)rec.seed, rec.events.size());
+    }
+    else if (recordPath)
+    {
+        rec.mode = INPUT_RECORD;
+        rec.log = fopen(recordPath, "wb");
+        if (!rec.log)
+        {
+            fprintf(stderr, "ERROR: could not write input log %s\n", recordPath);
+            return false;
+        }
+        InputLogHeader header;
+        memcpy(header.magic, kInputLogMagic, 4);
+        header.version = 1;
+        header.seed = rec.seed;
+        fwrite(&header, sizeof(header), 1, rec.log);
+    }
+
+    if (timingPath)
+    {
+        rec.timing = fopen(timingPath, "w");
+        if (rec.timing)
+            fprintf(rec.timing, "frame,ms\n");
+    }
+    if (rec.headless)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    return true;
+}
+
+inline void WriteInputEvent(InputRecorder& rec, uint32_t type, double x, double y)
+{
+    InputEvent event = { rec.frame, type, x, y };
+    fwrite(&event, sizeof(event), 1, rec.log);
+}
+
+// Installs the demo's cursor callback: live input drives it unless we are replaying.
+inline void SetInputCursorCallback(InputRecorder& rec, GLFWwindow* window, GLFWcursorposfun callback)
+{
+    rec.cursorCallback = callback;
+    if (rec.mode != INPUT_REPLAY)
+        glfwSetCursorPosCallback(window, callback);
+}
+
+// Call at the top of the demo's cursor callback.
+inline void RecordCursor(InputRecorder& rec, double x, double y)
+{
+    if (rec.mode == INPUT_RECORD)
+        WriteInputEvent(rec, INPUT_CURSOR, x, y);
+}
+
+// Start of a frame: returns the time the frame should use instead of glfwGetTime().
+inline double BeginInputFrame(InputRecorder& rec)
+{
+    if (rec.frame == 0 && rec.headless)
+        glfwSwapInterval(0); // time the work, not the display
+    rec.frameStart = std::chrono::steady_clock::now();
+    if (rec.mode == INPUT_REPLAY)
+    {
+        while (rec.next < rec.events.size() && rec.events[rec.next].frame < rec.frame)
+            rec.next++;
+        if (rec.next < rec.events.size() && rec.events[rec.next].frame == rec.frame &&
+            rec.events[rec.next].type == INPUT_FRAME)
+            rec.frameTime = rec.events[rec.next++].x;
+        return rec.frameTime;
+    }
+    rec.frameTime = glfwGetTime();
+    if (rec.mode == INPUT_RECORD)
+        WriteInputEvent(rec, INPUT_FRAME, rec.frameTime, 0.0);
+    return rec.frameTime;
+}
+
+// Replaces glfwPollEvents at the end of a frame. When a replay runs out the window is closed.
+// waitSeconds > 0 blocks until an event arrives or the timeout expires (live input only; a
+// replay never waits).
+inline void PollInput(InputRecorder& rec, GLFWwindow* window, double waitSeconds = 0.0)
+{
+    if (waitSeconds > 0.0 && rec.mode != INPUT_REPLAY)
+        glfwWaitEventsTimeout(waitSeconds);
+    else
+        glfwPollEvents();
+    if (rec.mode == INPUT_REPLAY)
+    {
+        while (rec.next < rec.events.size() && rec.events[rec.next].frame == rec.frame)
+        {
+            const InputEvent& event = rec.events[rec.next++];
+            if (event.type == INPUT_CURSOR && rec.cursorCallback)
+                rec.cursorCallback(window, event.x, event.y);
+        }
+        if (rec.next >= rec.events.size() || rec.events[rec.next].type == INPUT_END)
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
+    }
+
+    if (rec.timing)
+    {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - rec.frameStart).count();
+        fprintf(rec.timing, "%u,%.4f\n", rec.frame, ms);
+    }
+    rec.frame++;
+}
+
+inline void CloseInputRecorder(InputRecorder& rec)
+{
+    if (rec.log)
+    {
+        WriteInputEvent(rec, INPUT_END, 0.0, 0.0);
+        fclose(rec.log);
+        rec.log = NULL;
+    }
+    if (rec.timing)
+    {
+        fclose(rec.timing);
+        rec.timing = NULL;
+    }
+}
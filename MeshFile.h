@@ -0,0 +1,240 @@
+// Binary mesh container (.mesh)
+// Layout on disk, every blob aligned to kMeshFileAlignment bytes:
+//   MeshFileHeader | vertex blob | index blob | meshlets (optional)
+// The vertex blob is already in the GPU layout described by the header, so loading is
+// just a memory map: OpenMeshFile returns pointers into the mapping and UploadMeshFile
+// hands them straight to glBufferData. Files are written by obj2mesh.cpp; opencube --mesh
+// draws one.
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#ifdef GLEW_VERSION
+#include "GLTracker.h"
+#endif
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const char kMeshFileMagic[4] = { 'M', 'S', 'H', '1' };
+const uint32_t kMeshFileVersion = 1;
+const uint32_t kMeshFileAlignment = 64;
+const int kMeshFileMaxAttribs = 8;
+
+// Values are GL enums (GL_FLOAT, GL_UNSIGNED_INT, ...) so the loader can pass them through.
+struct MeshFileAttrib
+{
+    uint32_t location;
+    uint32_t components;
+    uint32_t type;
+    uint32_t normalized;
+    uint32_t offset;
+};
+
+struct MeshFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t vertexCount;
+    uint32_t vertexStride;
+    uint32_t indexCount;
+    uint32_t indexType;       // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    uint32_t attribCount;
+    uint32_t meshletCount;
+    MeshFileAttrib attribs[kMeshFileMaxAttribs];
+    uint64_t vertexOffset, vertexSize;
+    uint64_t indexOffset, indexSize;
+    uint64_t meshletOffset;
+    float boundsMin[3], boundsMax[3];
+};
+
+// A run of at most 64 vertices / 124 triangles of the index buffer, with a bounding sphere.
+struct MeshFileMeshlet
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float center[3];
+    float radius;
+};
+
+struct MeshFile
+{
+    const MeshFileHeader* header = NULL;
+    const void* vertices = NULL;
+    const void* indices = NULL;
+    const MeshFileMeshlet* meshlets = NULL;
+
+    // mapping
+    void* base = NULL;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE, mapping = NULL;
+#endif
+};
+
+inline uint64_t AlignMeshOffset(uint64_t offset)
+{
+    return (offset + kMeshFileAlignment - 1) / kMeshFileAlignment * kMeshFileAlignment;
+}
+
+inline void CloseMeshFile(MeshFile& mesh)
+{
+#ifdef _WIN32
+    if (mesh.base) UnmapViewOfFile(mesh.base);
+    if (mesh.mapping) CloseHandle(mesh.mapping);
+    if (mesh.file != INVALID_HANDLE_VALUE) CloseHandle(mesh.file);
+    mesh.mapping = NULL;
+    mesh.file = INVALID_HANDLE_VALUE;
+#else
+    if (mesh.base) munmap(mesh.base, mesh.size);
+#endif
+    mesh.base = NULL;
+    mesh.size = 0;
+    mesh.header = NULL;
+    mesh.vertices = mesh.indices = NULL;
+    mesh.meshlets = NULL;
+}
+
+inline bool MeshRangeValid(const MeshFile& mesh, uint64_t offset, uint64_t size)
+{
+    return offset % kMeshFileAlignment == 0 && offset <= mesh.size && size <= mesh.size - offset;
+}
+
+// Byte size of a GL component type a mesh file may use, 0 for anything else. Raw enum
+// values so the header stays GL-free.
+inline uint32_t MeshTypeSize(uint32_t type)
+{
+    switch (type)
+    {
+    case 0x1400: // GL_BYTE
+    case 0x1401: // GL_UNSIGNED_BYTE
+        return 1;
+    case 0x1402: // GL_SHORT
+    case 0x1403: // GL_UNSIGNED_SHORT
+    case 0x140B: // GL_HALF_FLOAT
+        return 2;
+    case 0x1404: // GL_INT
+    case 0x1405: // GL_UNSIGNED_INT
+    case 0x1406: // GL_FLOAT
+        return 4;
+    }
+    return 0;
+}
+
+// Indices are 16 or 32 bit and fill the index blob exactly; every attribute lies inside a vertex.
+inline bool MeshLayoutValid(const MeshFileHeader& h)
+{
+    if (h.indexType != 0x1403 && h.indexType != 0x1405) // GL_UNSIGNED_SHORT, GL_UNSIGNED_INT
+        return false;
+    if (h.indexSize != (uint64_t)h.indexCount * MeshTypeSize(h.indexType))
+        return false;
+    for (uint32_t i = 0; i < h.attribCount; i++)
+    {
+        const MeshFileAttrib& a = h.attribs[i];
+        uint32_t typeSize = MeshTypeSize(a.type);
+        if (typeSize == 0 || a.components < 1 || a.components > 4 ||
+            (uint64_t)a.offset + (uint64_t)a.components * typeSize > h.vertexStride)
+            return false;
+    }
+    return true;
+}
+
+// Maps the file read-only and validates the header. No data is copied or parsed.
+inline bool OpenMeshFile(const char* path, MeshFile& mesh)
+{
+#ifdef _WIN32
+    mesh.file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (mesh.file == INVALID_HANDLE_VALUE)
+    {
+        fprintf(stderr, "ERROR: could not open mesh %s\n", path);
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(mesh.file, &fileSize);
+    mesh.size = (size_t)fileSize.QuadPart;
+    mesh.mapping = mesh.size ? CreateFileMappingA(mesh.file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    mesh.base = mesh.mapping ? MapViewOfFile(mesh.mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "ERROR: could not open mesh %s\n", path);
+        return false;
+    }
+    struct stat st;
+    fstat(fd, &st);
+    mesh.size = (size_t)st.st_size;
+    mesh.base = mesh.size ? mmap(NULL, mesh.size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+    if (mesh.base == MAP_FAILED)
+        mesh.base = NULL;
+    close(fd); // the mapping keeps the file alive
+#endif
+    if (!mesh.base || mesh.size < sizeof(MeshFileHeader))
+    {
+        fprintf(stderr, "ERROR: could not map mesh %s\n", path);
+        CloseMeshFile(mesh);
+        return false;
+    }
+
+    const MeshFileHeader* h = (const MeshFileHeader*)mesh.base;
+    if (memcmp(h->magic, kMeshFileMagic, 4) != 0 || h->version != kMeshFileVersion ||
+        h->attribCount > (uint32_t)kMeshFileMaxAttribs ||
+        !MeshLayoutValid(*h) ||
+        h->vertexSize != (uint64_t)h->vertexCount * h->vertexStride ||
+        !MeshRangeValid(mesh, h->vertexOffset, h->vertexSize) ||
+        !MeshRangeValid(mesh, h->indexOffset, h->indexSize) ||
+        (h->meshletCount && !MeshRangeValid(mesh, h->meshletOffset, (uint64_t)h->meshletCount * sizeof(MeshFileMeshlet))))
+    {
+        fprintf(stderr, "ERROR: %s is not a valid version %u mesh file\n", path, kMeshFileVersion);
+        CloseMeshFile(mesh);
+        return false;
+    }
+
+    const char* bytes = (const char*)mesh.base;
+    mesh.header = h;
+    mesh.vertices = bytes + h->vertexOffset;
+    mesh.indices = bytes + h->indexOffset;
+    mesh.meshlets = h->meshletCount ? (const MeshFileMeshlet*)(bytes + h->meshletOffset) : NULL;
+#ifndef _WIN32
+    madvise(mesh.base, mesh.size, MADV_SEQUENTIAL);
+#endif
+    return true;
+}
+
+#ifdef GLEW_VERSION
+// Creates VAO + VBO + EBO straight from the mapping. Draw with
+// glDrawElements(GL_TRIANGLES, header->indexCount, header->indexType, 0).
+inline void UploadMeshFile(const MeshFile& mesh, unsigned int* vao, unsigned int* vbo, unsigned int* ebo,
+                           GL_SITE_PARAMS)
+{
+    const MeshFileHeader* h = mesh.header;
+    glGenVertexArrays(1, vao);
+    glBindVertexArray(*vao);
+    glGenBuffers(1, vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, *vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)h->vertexSize, mesh.vertices, GL_STATIC_DRAW);
+    glGenBuffers(1, ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)h->indexSize, mesh.indices, GL_STATIC_DRAW);
+    for (uint32_t i = 0; i < h->attribCount; i++)
+    {
+        const MeshFileAttrib& a = h->attribs[i];
+        glVertexAttribPointer(a.location, a.components, a.type, a.normalized ? GL_TRUE : GL_FALSE,
+                              h->vertexStride, (void*)(size_t)a.offset);
+        glEnableVertexAttribArray(a.location);
+    }
+    TrackGLObject(GL_VERTEX_ARRAY, *vao, "mesh", 0, GL_SITE_ARGS);
+    TrackGLObject(GL_BUFFER, *vbo, "mesh vertices", h->vertexSize, GL_SITE_ARGS);
+    TrackGLObject(GL_BUFFER, *ebo, "mesh indices", h->indexSize, GL_SITE_ARGS);
+}
+#endif
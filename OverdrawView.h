@@ -0,0 +1,184 @@
+// Overdraw / fill-rate debug view
+// While enabled the demo draws with CreateOverdrawProgram (its own vertex shader plus a
+// fragment shader that writes 1.0) into a float target with additive blending, so every
+// texel ends up holding the number of fragments shaded there. EndOverdrawFrame shows that
+// count as a heatmap (black 0, blue 1, green 2, yellow 3, red 4, magenta 5, white 6+) and logs the
+// GL_SAMPLES_PASSED of every pass as fragments per pixel.
+#pragma once
+
+#include "GL/glew.h"
+#include "GLTracker.h"
+#include "ProgramCache.h"
+
+#include <cstdio>
+
+const int kMaxOverdrawPasses = 8;
+
+const char* const overdrawFragmentSource = "#version 330 core\n"
+                                           "out vec4 FragColor;\n"
+                                           "void main()\n"
+                                           "{\n"
+                                           "    FragColor = vec4(1.0);\n"
+                                           "}\n\0";
+
+const char* const heatmapVertexSource = "#version 330 core\n"
+                                        "out vec2 TexCoord;\n"
+                                        "void main()\n"
+                                        "{\n"
+                                        "    vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+                                        "    TexCoord = p;\n"
+                                        "    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);\n"
+                                        "}\n\0";
+
+const char* const heatmapFragmentSource = "#version 330 core\n"
+                                          "in vec2 TexCoord;\n"
+                                          "uniform sampler2D counts;\n"
+                                          "out vec4 FragColor;\n"
+                                          "void main()\n"
+                                          "{\n"
+                                          "    float n = texture(counts, TexCoord).r;\n"
+                                          "    vec3 ramp[7] = vec3[](vec3(0.0), vec3(0.0, 0.0, 1.0), vec3(0.0, 1.0, 0.0),\n"
+                                          "                          vec3(1.0, 1.0, 0.0), vec3(1.0, 0.0, 0.0), vec3(1.0, 0.0, 1.0), vec3(1.0));\n"
+                                          "    int i = int(clamp(n, 0.0, 6.0));\n"
+                                          "    FragColor = vec4(mix(ramp[i], ramp[min(i + 1, 6)], clamp(n - float(i), 0.0, 1.0)), 1.0);\n"
+                                          "}\n\0";
+
+struct OverdrawView
+{
+    bool enabled = false;
+    int width = 0, height = 0;
+    unsigned int fbo = 0, countTexture = 0, depthBuffer = 0;
+    unsigned int heatmapProgram = 0, emptyVAO = 0;
+
+    unsigned int queries[kMaxOverdrawPasses] = {};
+    const char* passNames[kMaxOverdrawPasses] = {};
+    int passCount = 0;
+
+    // accumulated between two log lines
+    unsigned long long passSamples[kMaxOverdrawPasses] = {};
+    int frames = 0;
+    double lastLogTime = 0.0;
+};
+
+// The demo's vertex shader with a fragment shader that only counts.
+inline unsigned int CreateOverdrawProgram(const char* vertexSource, GL_SITE_PARAMS)
+{
+    return LoadShaderProgram("overdraw", vertexSource, overdrawFragmentSource, "", GL_SITE_ARGS);
+}
+
+inline void InitOverdrawView(OverdrawView& view, int width, int height)
+{
+    view.enabled = true;
+    view.width = width;
+    view.height = height;
+
+    glGenTextures(1, &view.countTexture);
+    glBindTexture(GL_TEXTURE_2D, view.countTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, width, height, 0, GL_RED, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glGenRenderbuffers(1, &view.depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, view.depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+    glGenFramebuffers(1, &view.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, view.fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, view.countTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, view.depthBuffer);
+    GL_TRACK(GL_TEXTURE, view.countTexture, "overdraw counts", GLImageBytes(GL_R32F, width, height, false));
+    GL_TRACK(GL_RENDERBUFFER, view.depthBuffer, "overdraw depth", GLImageBytes(GL_DEPTH_COMPONENT24, width, height, false));
+    GL_TRACK(GL_FRAMEBUFFER, view.fbo, "overdraw", 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        fprintf(stderr, "ERROR: overdraw framebuffer is incomplete\n");
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glGenQueries(kMaxOverdrawPasses, view.queries);
+    TrackGLObjects(GL_QUERY, kMaxOverdrawPasses, view.queries, "overdraw samples", 0, __FILE__, __LINE__);
+    glGenVertexArrays(1, &view.emptyVAO);
+    glBindVertexArray(view.emptyVAO);
+    GL_TRACK(GL_VERTEX_ARRAY, view.emptyVAO, "overdraw heatmap", 0);
+    view.heatmapProgram = LoadShaderProgram("overdraw heatmap", heatmapVertexSource, heatmapFragmentSource);
+}
+
+inline void BeginOverdrawFrame(OverdrawView& view)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, view.fbo);
+    glViewport(0, 0, view.width, view.height);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    view.passCount = 0;
+}
+
+// Passes can not nest: GL allows one GL_SAMPLES_PASSED query at a time.
+inline void BeginOverdrawPass(OverdrawView& view, const char* name)
+{
+    if (view.passCount >= kMaxOverdrawPasses)
+        return;
+    view.passNames[view.passCount] = name;
+    glBeginQuery(GL_SAMPLES_PASSED, view.queries[view.passCount]);
+}
+
+inline void EndOverdrawPass(OverdrawView& view)
+{
+    if (view.passCount >= kMaxOverdrawPasses)
+        return;
+    glEndQuery(GL_SAMPLES_PASSED);
+    view.passCount++;
+}
+
+// Draws the heatmap to the default framebuffer and logs once per second.
+// Reading the query results right away stalls, which is acceptable in this debug mode.
+inline void EndOverdrawFrame(OverdrawView& view, double time)
+{
+    for (int i = 0; i < view.passCount; i++)
+    {
+        GLuint64 samples = 0;
+        glGetQueryObjectui64v(view.queries[i], GL_QUERY_RESULT, &samples);
+        view.passSamples[i] += samples;
+    }
+    view.frames++;
+
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDisable(GL_BLEND);
+    glDisable(GL_DEPTH_TEST);
+    glUseProgram(view.heatmapProgram);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, view.countTexture);
+    glUniform1i(glGetUniformLocation(view.heatmapProgram, "counts"), 0);
+    glBindVertexArray(view.emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    if (depthTest)
+        glEnable(GL_DEPTH_TEST);
+
+    if (time - view.lastLogTime >= 1.0)
+    {
+        double pixels = (double)view.width * view.height * view.frames;
+        double total = 0.0;
+        printf("overdraw:");
+        for (int i = 0; i < view.passCount; i++)
+        {
+            printf(" %s %.3f", view.passNames[i], view.passSamples[i] / pixels);
+            total += view.passSamples[i];
+            view.passSamples[i] = 0;
+        }
+        printf(" | %.3f fragments/pixel/frame over %d frames\n", total / pixels, view.frames);
+        view.frames = 0;
+        view.lastLogTime = time;
+    }
+}
+
+inline void DestroyOverdrawView(OverdrawView& view)
+{
+    if (!view.enabled)
+        return;
+    DeleteGLObjects(GL_PROGRAM, 1, &view.heatmapProgram);
+    DeleteGLObjects(GL_VERTEX_ARRAY, 1, &view.emptyVAO);
+    DeleteGLObjects(GL_QUERY, kMaxOverdrawPasses, view.queries);
+    DeleteGLObjects(GL_FRAMEBUFFER, 1, &view.fbo);
+    DeleteGLObjects(GL_RENDERBUFFER, 1, &view.depthBuffer);
+    DeleteGLObjects(GL_TEXTURE, 1, &view.countTexture);
+}
@@ -0,0 +1,423 @@
+// Performance HUD
+//   --hud   overlay with FPS, a rolling frame-time graph, draw calls and per-scope CPU / GPU times
+// Text comes from a 5x7 bitmap font that the compiler bakes into an R8 atlas; every glyph,
+// bar and panel of the overlay is a textured quad written into one vertex batch (streamed
+// through a StreamBuffer) and drawn with a single glDrawArrays.
+// Scenes report into the one perfHud of the process:
+//   BeginHudScope("belt"); ... EndHudScope();   CPU time + GPU time (GL_TIMESTAMP queries)
+//   HudCountDraws(n);                           draw calls issued this frame
+// The main loop calls BeginHudFrame() before the scene and DrawHud() after it, before the
+// capture and the swap. All of these return at once while the HUD is disabled.
+#pragma once
+
+#include "GL/glew.h"
+#include "GLTracker.h"
+#include "ProgramCache.h"
+#include "StreamBuffer.h"
+#include "VertexLayout.h"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// 5x7 glyphs for ' ' .. '_' (lowercase is drawn as uppercase), one row per byte, bit 4 = left.
+constexpr unsigned char kHudFont[64][7] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 }, //   !
+    { 0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00 }, { 0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A }, // " #
+    { 0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04 }, { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 }, // $ %
+    { 0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D }, { 0x0C, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 }, // & '
+    { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 }, { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 }, // ( )
+    { 0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00 }, { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 }, // * +
+    { 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 }, { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 }, // , -
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C }, { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 }, // . /
+    { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E }, { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E }, // 0 1
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F }, { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E }, // 2 3
+    { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 }, { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E }, // 4 5
+    { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E }, { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 }, // 6 7
+    { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E }, { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C }, // 8 9
+    { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 }, { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08 }, // : ;
+    { 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 }, { 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00 }, // < =
+    { 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 }, { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 }, // > ?
+    { 0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E }, { 0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11 }, // @ A
+    { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E }, { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E }, // B C
+    { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C }, { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F }, // D E
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 }, { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F }, // F G
+    { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 }, { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E }, // H I
+    { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C }, { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 }, // J K
+    { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F }, { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 }, // L M
+    { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 }, { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // N O
+    { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 }, { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D }, // P Q
+    { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 }, { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E }, // R S
+    { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 }, { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // T U
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 }, { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A }, // V W
+    { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 }, { 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 }, // X Y
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F }, { 0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E }, // Z [
+    { 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00 }, { 0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E }, // \ ]
+    { 0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F }, // ^ _
+};
+
+// Atlas: 16 x 4 cells of 6 x 8 texels (the glyph plus one blank column and row), row 0 on top.
+const int kHudCellWidth = 6, kHudCellHeight = 8, kHudAtlasColumns = 16;
+const int kHudAtlasWidth = kHudCellWidth * kHudAtlasColumns, kHudAtlasHeight = kHudCellHeight * 4;
+
+constexpr std::array<unsigned char, kHudAtlasWidth * kHudAtlasHeight> MakeHudFontAtlas()
+{
+    std::array<unsigned char, kHudAtlasWidth * kHudAtlasHeight> atlas{};
+    for (int glyph = 0; glyph < 64; glyph++)
+    {
+        int x0 = glyph % kHudAtlasColumns * kHudCellWidth, y0 = glyph / kHudAtlasColumns * kHudCellHeight;
+        for (int row = 0; row < 7; row++)
+            for (int column = 0; column < 5; column++)
+                if (kHudFont[glyph][row] & (0x10 >> column))
+                    atlas[(y0 + row) * kHudAtlasWidth + x0 + column] = 255;
+    }
+    return atlas;
+}
+
+inline constexpr auto kHudFontAtlas = MakeHudFontAtlas();
+
+const int kHudHistory = 120;       // frames in the graph
+const int kHudMaxScopes = 8;
+const int kHudLatency = 4;         // frames between a timestamp query and reading it back
+const int kHudMaxVertices = 8192;  // per frame; quads beyond this are dropped
+const int kHudScale = 2;           // screen pixels per font texel
+const float kHudGraphMs = 33.3f;   // frame time at the top of the graph
+
+// Position in pixels from the top-left corner; uv.x < 0 means solid (no font lookup).
+struct HudVertex
+{
+    float position[2] = {};
+    float uv[2] = {};
+    unsigned char color[4] = {};
+};
+
+using HudLayout = VertexLayout<HudVertex, Attrib<0, float, 2>, Attrib<1, float, 2>, Attrib<2, unsigned char, 4, true>>;
+static_assert(HudLayout::MatchesMembers({ offsetof(HudVertex, position), offsetof(HudVertex, uv),
+                                          offsetof(HudVertex, color) }),
+              "HudLayout does not follow HudVertex");
+
+const char* const hudVertexSource = "#version 330 core\n"
+                                    "layout (location = 0) in vec2 aPos;\n"
+                                    "layout (location = 1) in vec2 aTexCoord;\n"
+                                    "layout (location = 2) in vec4 aColor;\n"
+                                    "uniform vec2 viewportSize;\n"
+                                    "out vec2 TexCoord;\n"
+                                    "out vec4 Color;\n"
+                                    "void main()\n"
+                                    "{\n"
+                                    "    TexCoord = aTexCoord;\n"
+                                    "    Color = aColor;\n"
+                                    "    gl_Position = vec4(aPos.x / viewportSize.x * 2.0 - 1.0, 1.0 - aPos.y / viewportSize.y * 2.0, 0.0, 1.0);\n"
+                                    "}\n\0";
+
+const char* const hudFragmentSource = "#version 330 core\n"
+                                      "in vec2 TexCoord;\n"
+                                      "in vec4 Color;\n"
+                                      "uniform sampler2D font;\n"
+                                      "out vec4 FragColor;\n"
+                                      "void main()\n"
+                                      "{\n"
+                                      "    float coverage = TexCoord.x < 0.0 ? 1.0 : texture(font, TexCoord).r;\n"
+                                      "    FragColor = vec4(Color.rgb, Color.a * coverage);\n"
+                                      "}\n\0";
+
+struct HudScope
+{
+    const char* name = NULL;
+    std::chrono::steady_clock::time_point cpuStart;
+    double cpuMs = 0.0;                  // this frame, summed over every Begin/End pair
+    double cpuSmoothed = 0.0, gpuSmoothed = 0.0;
+    unsigned int queries[kHudLatency][2] = {};
+    bool pending[kHudLatency] = {};
+    unsigned int queriedFrame = ~0u;     // one GPU interval per scope and frame
+};
+
+struct PerfHud
+{
+    bool enabled = false;
+    int width = 0, height = 0;
+    unsigned int program = 0, vao = 0, fontTexture = 0;
+    int viewportSizeLocation = -1;
+    StreamBuffer stream;
+    std::vector<HudVertex> vertices;
+
+    unsigned int frame = 0;
+    std::chrono::steady_clock::time_point frameStart;
+    float frameMs[kHudHistory] = {};
+    int historyHead = 0;
+    double fps = 0.0;
+    unsigned int fpsFrames = 0;
+    std::chrono::steady_clock::time_point fpsStart;
+
+    unsigned int drawCalls = 0, lastDrawCalls = 0;
+    HudScope scopes[kHudMaxScopes];
+    int scopeCount = 0;
+    int stack[kHudMaxScopes] = {};
+    int depth = 0;
+    double hudCpuMs = 0.0; // what building and drawing the HUD itself cost
+};
+
+inline PerfHud perfHud; // one per process, so scenes can report without being handed it
+
+inline bool InitPerfHud(int width, int height)
+{
+    PerfHud& hud = perfHud;
+    hud.width = width;
+    hud.height = height;
+    hud.program = LoadShaderProgram("hud", hudVertexSource, hudFragmentSource);
+    glUseProgram(hud.program);
+    glUniform1i(glGetUniformLocation(hud.program, "font"), 0);
+    hud.viewportSizeLocation = glGetUniformLocation(hud.program, "viewportSize");
+
+    glGenTextures(1, &hud.fontTexture);
+    glBindTexture(GL_TEXTURE_2D, hud.fontTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, kHudAtlasWidth, kHudAtlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE,
+                 kHudFontAtlas.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    GL_TRACK(GL_TEXTURE, hud.fontTexture, "hud font", GLImageBytes(GL_R8, kHudAtlasWidth, kHudAtlasHeight, false));
+
+    glGenVertexArrays(1, &hud.vao);
+    glBindVertexArray(hud.vao);
+    GL_TRACK(GL_VERTEX_ARRAY, hud.vao, "hud", 0);
+    InitStreamBuffer(hud.stream, (GLsizeiptr)kHudMaxVertices * sizeof(HudVertex));
+    HudLayout::Apply(); // each frame's batch starts at a multiple of the stride, drawn with "first"
+    glBindVertexArray(0);
+    hud.vertices.reserve(kHudMaxVertices);
+
+    hud.frameStart = hud.fpsStart = std::chrono::steady_clock::now();
+    hud.enabled = true;
+    return hud.program != 0;
+}
+
+inline void DestroyPerfHud()
+{
+    PerfHud& hud = perfHud;
+    if (!hud.enabled)
+        return;
+    for (int i = 0; i < hud.scopeCount; i++)
+        DeleteGLObjects(GL_QUERY, kHudLatency * 2, &hud.scopes[i].queries[0][0]);
+    DestroyStreamBuffer(hud.stream);
+    DeleteGLObjects(GL_VERTEX_ARRAY, 1, &hud.vao);
+    DeleteGLObjects(GL_TEXTURE, 1, &hud.fontTexture);
+    DeleteGLObjects(GL_PROGRAM, 1, &hud.program);
+    hud.scopeCount = 0;
+    hud.enabled = false;
+}
+
+inline void HudCountDraws(unsigned int count)
+{
+    perfHud.drawCalls += count;
+}
+
+inline void BeginHudScope(const char* name)
+{
+    PerfHud& hud = perfHud;
+    if (!hud.enabled || hud.depth == kHudMaxScopes)
+        return;
+    int index = 0;
+    while (index < hud.scopeCount && strcmp(hud.scopes[index].name, name) != 0)
+        index++;
+    if (index == hud.scopeCount)
+    {
+        if (hud.scopeCount == kHudMaxScopes)
+            return;
+        hud.scopes[index].name = name;
+        glGenQueries(kHudLatency * 2, &hud.scopes[index].queries[0][0]);
+        TrackGLObjects(GL_QUERY, kHudLatency * 2, &hud.scopes[index].queries[0][0], "hud timestamp", 0, __FILE__,
+                       __LINE__);
+        hud.scopeCount++;
+    }
+    HudScope& scope = hud.scopes[index];
+    hud.stack[hud.depth++] = index;
+    int slot = hud.frame % kHudLatency;
+    if (scope.queriedFrame != hud.frame && !scope.pending[slot])
+        glQueryCounter(scope.queries[slot][0], GL_TIMESTAMP);
+    scope.cpuStart = std::chrono::steady_clock::now();
+}
+
+inline void EndHudScope()
+{
+    PerfHud& hud = perfHud;
+    if (!hud.enabled || hud.depth == 0)
+        return;
+    HudScope& scope = hud.scopes[hud.stack[--hud.depth]];
+    scope.cpuMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - scope.cpuStart).count();
+    int slot = hud.frame % kHudLatency;
+    if (scope.queriedFrame != hud.frame && !scope.pending[slot])
+    {
+        glQueryCounter(scope.queries[slot][1], GL_TIMESTAMP);
+        scope.pending[slot] = true;
+        scope.queriedFrame = hud.frame;
+    }
+}
+
+// Start of a frame: closes the previous one (frame time, FPS, scope CPU times) and reads the
+// timestamps issued kHudLatency frames ago, if the GPU has finished them.
+inline void BeginHudFrame()
+{
+    PerfHud& hud = perfHud;
+    if (!hud.enabled)
+        return;
+    auto now = std::chrono::steady_clock::now();
+    if (hud.frame > 0)
+    {
+        hud.frameMs[hud.historyHead] = (float)std::chrono::duration<double, std::milli>(now - hud.frameStart).count();
+        hud.historyHead = (hud.historyHead + 1) % kHudHistory;
+    }
+    hud.frameStart = now;
+    hud.fpsFrames++;
+    double fpsSeconds = std::chrono::duration<double>(now - hud.fpsStart).count();
+    if (fpsSeconds >= 0.5)
+    {
+        hud.fps = hud.fpsFrames / fpsSeconds;
+        hud.fpsFrames = 0;
+        hud.fpsStart = now;
+    }
+
+    hud.frame++;
+    int slot = hud.frame % kHudLatency;
+    for (int i = 0; i < hud.scopeCount; i++)
+    {
+        HudScope& scope = hud.scopes[i];
+        scope.cpuSmoothed += (scope.cpuMs - scope.cpuSmoothed) * 0.1;
+        scope.cpuMs = 0.0;
+        if (!scope.pending[slot])
+            continue;
+        GLint available = 0;
+        glGetQueryObjectiv(scope.queries[slot][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            continue; // the slot stays busy; this frame issues no new interval
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(scope.queries[slot][0], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(scope.queries[slot][1], GL_QUERY_RESULT, &end);
+        scope.gpuSmoothed += ((end - begin) / 1e6 - scope.gpuSmoothed) * 0.1;
+        scope.pending[slot] = false;
+    }
+    hud.lastDrawCalls = hud.drawCalls;
+    hud.drawCalls = 0;
+}
+
+inline void AddHudQuad(float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1,
+                       const unsigned char color[4])
+{
+    std::vector<HudVertex>& out = perfHud.vertices;
+    if (out.size() + 6 > (size_t)kHudMaxVertices)
+        return;
+    const float corners[6][4] = { { x0, y0, u0, v0 }, { x0, y1, u0, v1 }, { x1, y1, u1, v1 },
+                                  { x1, y1, u1, v1 }, { x1, y0, u1, v0 }, { x0, y0, u0, v0 } };
+    for (const auto& corner : corners)
+    {
+        HudVertex vertex;
+        vertex.position[0] = corner[0];
+        vertex.position[1] = corner[1];
+        vertex.uv[0] = corner[2];
+        vertex.uv[1] = corner[3];
+        memcpy(vertex.color, color, 4);
+        out.push_back(vertex);
+    }
+}
+
+inline void AddHudRect(float x, float y, float width, float height, const unsigned char color[4])
+{
+    AddHudQuad(x, y, x + width, y + height, -1.0f, -1.0f, -1.0f, -1.0f, color);
+}
+
+// Returns the x after the last character.
+inline float AddHudText(float x, float y, const char* text, const unsigned char color[4])
+{
+    for (; *text; text++)
+    {
+        int c = (unsigned char)*text;
+        if (c >= 'a' && c <= 'z')
+            c -= 'a' - 'A';
+        if (c > ' ' && c <= '_')
+        {
+            int glyph = c - ' ';
+            float u0 = (float)(glyph % kHudAtlasColumns * kHudCellWidth) / kHudAtlasWidth;
+            float v0 = (float)(glyph / kHudAtlasColumns * kHudCellHeight) / kHudAtlasHeight;
+            float u1 = u0 + 5.0f / kHudAtlasWidth, v1 = v0 + 7.0f / kHudAtlasHeight;
+            AddHudQuad(x, y, x + 5 * kHudScale, y + 7 * kHudScale, u0, v0, u1, v1, color);
+        }
+        x += kHudCellWidth * kHudScale;
+    }
+    return x;
+}
+
+// Builds the whole overlay into one batch and draws it over the default framebuffer.
+inline void DrawHud()
+{
+    PerfHud& hud = perfHud;
+    if (!hud.enabled)
+        return;
+    BeginHudScope("hud");
+    auto start = std::chrono::steady_clock::now();
+    const unsigned char panel[4] = { 0, 0, 0, 160 }, white[4] = { 255, 255, 255, 255 };
+    const unsigned char grey[4] = { 160, 160, 160, 255 }, green[4] = { 80, 220, 80, 255 };
+    const unsigned char yellow[4] = { 240, 200, 40, 255 }, red[4] = { 240, 60, 60, 255 };
+    const float margin = 8.0f, line = (kHudCellHeight + 2) * kHudScale;
+    const float graphWidth = kHudHistory * 2.0f, graphHeight = 60.0f;
+    hud.vertices.clear();
+
+    float panelHeight = margin + line * (3 + hud.scopeCount) + graphHeight + margin;
+    AddHudRect(0.0f, 0.0f, graphWidth + 2 * margin + 80.0f, panelHeight, panel);
+
+    char text[96];
+    float lastMs = hud.frameMs[(hud.historyHead + kHudHistory - 1) % kHudHistory];
+    float y = margin;
+    snprintf(text, sizeof(text), "FPS %.1f  %.2f MS", hud.fps, lastMs);
+    AddHudText(margin, y, text, white);
+    y += line;
+    snprintf(text, sizeof(text), "DRAWS %u  HUD %.3f MS", hud.lastDrawCalls, hud.hudCpuMs);
+    AddHudText(margin, y, text, white);
+    y += line;
+    AddHudText(margin, y, "SCOPE       CPU MS  GPU MS", grey);
+    y += line;
+    for (int i = 0; i < hud.scopeCount; i++)
+    {
+        const HudScope& scope = hud.scopes[i];
+        snprintf(text, sizeof(text), "%-10.10s %7.3f %7.3f", scope.name, scope.cpuSmoothed, scope.gpuSmoothed);
+        AddHudText(margin, y, text, white);
+        y += line;
+    }
+
+    // frame-time graph, oldest bar on the left, with a line at 16.7 ms
+    float bottom = y + graphHeight;
+    for (int i = 0; i < kHudHistory; i++)
+    {
+        float ms = hud.frameMs[(hud.historyHead + i) % kHudHistory];
+        float height = ms / kHudGraphMs * graphHeight;
+        if (height > graphHeight)
+            height = graphHeight;
+        const unsigned char* color = ms < 17.0f ? green : (ms < kHudGraphMs ? yellow : red);
+        AddHudRect(margin + i * 2.0f, bottom - height, 2.0f, height, color);
+    }
+    AddHudRect(margin, bottom - 16.7f / kHudGraphMs * graphHeight, graphWidth, 1.0f, grey);
+
+    BeginStreamFrame(hud.stream);
+    GLintptr offset = StreamUpload(hud.stream, hud.vertices.data(), (GLsizeiptr)(hud.vertices.size() * sizeof(HudVertex)),
+                                   HudLayout::stride);
+    if (offset >= 0)
+    {
+        glViewport(0, 0, hud.width, hud.height);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_CULL_FACE);
+        glDisable(GL_SCISSOR_TEST);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glUseProgram(hud.program);
+        glUniform2f(hud.viewportSizeLocation, (float)hud.width, (float)hud.height);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, hud.fontTexture);
+        glBindVertexArray(hud.vao);
+        glDrawArrays(GL_TRIANGLES, (GLint)(offset / HudLayout::stride), (GLsizei)hud.vertices.size());
+        glBindVertexArray(0);
+    }
+    EndStreamFrame(hud.stream);
+    hud.hudCpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    EndHudScope();
+}
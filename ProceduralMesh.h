@@ -0,0 +1,148 @@
+// Compile-time procedural meshes
+// The generators are constexpr, so the k* meshes at the bottom are computed by the compiler
+// and end up in the executable's read-only data: nothing is generated at startup.
+// Every mesh is centred on the origin with unit size parameters; scale it with the model
+// matrix instead of regenerating it.
+#pragma once
+
+#include "VertexLayout.h"
+
+#include <array>
+
+constexpr double kConstPi = 3.14159265358979323846;
+
+// std::sin/std::cos are not constexpr: Taylor series after reducing x to [-pi, pi].
+constexpr double ConstSin(double x)
+{
+    while (x > kConstPi)
+        x -= 2.0 * kConstPi;
+    while (x < -kConstPi)
+        x += 2.0 * kConstPi;
+    double term = x, sum = x;
+    for (int n = 1; n < 14; n++)
+    {
+        term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double ConstCos(double x)
+{
+    return ConstSin(x + kConstPi / 2.0);
+}
+
+// Circle outline in the XY plane, counter-clockwise from (radius, 0); draw as GL_TRIANGLE_FAN.
+template <int Segments>
+constexpr std::array<PositionVertex, Segments> MakeCircle(float radius = 1.0f)
+{
+    std::array<PositionVertex, Segments> circle{};
+    for (int i = 0; i < Segments; i++)
+    {
+        double angle = 2.0 * kConstPi * i / Segments;
+        circle[i].position[0] = (float)(radius * ConstCos(angle));
+        circle[i].position[1] = (float)(radius * ConstSin(angle));
+    }
+    return circle;
+}
+
+// Two counter-clockwise triangles in the XY plane, uv (0,0) at the bottom left; GL_TRIANGLES.
+constexpr std::array<TexturedVertex, 6> MakeQuad(float halfSize = 0.5f)
+{
+    const float corners[6][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 1, 1 }, { 0, 1 }, { 0, 0 } };
+    std::array<TexturedVertex, 6> quad{};
+    for (int i = 0; i < 6; i++)
+    {
+        quad[i].position[0] = (corners[i][0] * 2.0f - 1.0f) * halfSize;
+        quad[i].position[1] = (corners[i][1] * 2.0f - 1.0f) * halfSize;
+        quad[i].uv[0] = corners[i][0];
+        quad[i].uv[1] = corners[i][1];
+    }
+    return quad;
+}
+
+// 6 faces x 2 triangles, outward normals, counter-clockwise seen from outside; GL_TRIANGLES.
+constexpr std::array<MeshVertex, 36> MakeCube(float halfSize = 0.5f)
+{
+    // per face: normal axis and sign; the two other axes span the face
+    const int axis[6] = { 0, 0, 1, 1, 2, 2 };
+    const float sign[6] = { 1, -1, 1, -1, 1, -1 };
+    const float corners[6][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 1, 1 }, { 0, 1 }, { 0, 0 } };
+    std::array<MeshVertex, 36> cube{};
+    for (int face = 0; face < 6; face++)
+    {
+        int n = axis[face], u = (n + 1) % 3, v = (n + 2) % 3;
+        for (int i = 0; i < 6; i++)
+        {
+            // mirror u on the negative faces so the winding stays counter-clockwise from outside
+            float s = corners[i][0], t = corners[i][1];
+            float pu = sign[face] > 0 ? s : 1.0f - s;
+            MeshVertex& vertex = cube[face * 6 + i];
+            vertex.position[n] = sign[face] * halfSize;
+            vertex.position[u] = (pu * 2.0f - 1.0f) * halfSize;
+            vertex.position[v] = (t * 2.0f - 1.0f) * halfSize;
+            vertex.normal[n] = sign[face];
+            vertex.uv[0] = s;
+            vertex.uv[1] = t;
+        }
+    }
+    return cube;
+}
+
+template <int Stacks, int Slices>
+struct SphereMesh
+{
+    static constexpr int vertexCount = (Stacks + 1) * (Slices + 1);
+    static constexpr int indexCount = Stacks * Slices * 6;
+    static_assert(vertexCount <= 65536, "indices are 16 bit");
+    std::array<MeshVertex, vertexCount> vertices{};
+    std::array<unsigned short, indexCount> indices{};
+};
+
+// Latitude/longitude sphere; the seam column is duplicated so uv wraps cleanly. GL_TRIANGLES,
+// indexed with GL_UNSIGNED_SHORT.
+template <int Stacks, int Slices>
+constexpr SphereMesh<Stacks, Slices> MakeUVSphere(float radius = 1.0f)
+{
+    SphereMesh<Stacks, Slices> sphere{};
+    for (int stack = 0; stack <= Stacks; stack++)
+    {
+        double phi = kConstPi * stack / Stacks; // 0 at the north pole
+        for (int slice = 0; slice <= Slices; slice++)
+        {
+            double theta = 2.0 * kConstPi * slice / Slices;
+            MeshVertex& vertex = sphere.vertices[stack * (Slices + 1) + slice];
+            vertex.normal[0] = (float)(ConstSin(phi) * ConstCos(theta));
+            vertex.normal[1] = (float)ConstCos(phi);
+            vertex.normal[2] = (float)(-ConstSin(phi) * ConstSin(theta));
+            for (int i = 0; i < 3; i++)
+                vertex.position[i] = vertex.normal[i] * radius;
+            vertex.uv[0] = (float)slice / Slices;
+            vertex.uv[1] = 1.0f - (float)stack / Stacks;
+        }
+    }
+    int index = 0;
+    for (int stack = 0; stack < Stacks; stack++)
+        for (int slice = 0; slice < Slices; slice++)
+        {
+            unsigned short a = (unsigned short)(stack * (Slices + 1) + slice), b = (unsigned short)(a + Slices + 1);
+            sphere.indices[index++] = a;
+            sphere.indices[index++] = b;
+            sphere.indices[index++] = (unsigned short)(a + 1);
+            sphere.indices[index++] = (unsigned short)(a + 1);
+            sphere.indices[index++] = b;
+            sphere.indices[index++] = (unsigned short)(b + 1);
+        }
+    return sphere;
+}
+
+// Baked at build time.
+inline constexpr auto kCircle16 = MakeCircle<16>();
+inline constexpr auto kCircle32 = MakeCircle<32>();
+inline constexpr auto kCircle64 = MakeCircle<64>();
+inline constexpr auto kCircle100 = MakeCircle<100>();
+inline constexpr auto kUnitQuad = MakeQuad(0.5f);
+inline constexpr auto kUnitCube = MakeCube(0.5f);
+inline constexpr auto kSphereLow = MakeUVSphere<6, 12>();
+inline constexpr auto kSphereMedium = MakeUVSphere<12, 24>();
+inline constexpr auto kSphereHigh = MakeUVSphere<24, 48>();
@@ -0,0 +1,188 @@
+// Shader program cache
+// Programs are keyed by a hash of their GLSL sources, the extra #defines and the
+// driver vendor/renderer/version strings. The first launch compiles and links as usual
+// and stores the glGetProgramBinary blob in shader_cache/; later launches try
+// glProgramBinary first and fall back to compiling when the driver rejects the blob.
+#pragma once
+
+#include "GL/glew.h"
+#include "GLTracker.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+const char* const kShaderCacheDir = "shader_cache";
+
+// 64-bit FNV-1a
+inline unsigned long long HashBytes(const void* data, size_t size, unsigned long long hash = 14695981039346656037ull)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+inline unsigned long long HashString(const char* text, unsigned long long hash = 14695981039346656037ull)
+{
+    // include the terminator so "ab"+"c" and "a"+"bc" hash differently
+    return HashBytes(text ? text : "", text ? strlen(text) + 1 : 1, hash);
+}
+
+inline unsigned long long HashProgramSources(const char* vertexSource, const char* fragmentSource, const char* defines)
+{
+    unsigned long long hash = HashString(vertexSource);
+    hash = HashString(fragmentSource, hash);
+    hash = HashString(defines, hash);
+    hash = HashString((const char*)glGetString(GL_VENDOR), hash);
+    hash = HashString((const char*)glGetString(GL_RENDERER), hash);
+    hash = HashString((const char*)glGetString(GL_VERSION), hash);
+    return hash;
+}
+
+// Compiles one stage. The defines are inserted right after the "#version" line.
+inline unsigned int CompileShaderStage(GLenum type, const char* source, const char* defines)
+{
+    const char* body = strchr(source, '\n');
+    body = body ? body + 1 : source + strlen(source);
+    std::string versionLine(source, body - source);
+    const char* parts[3] = { versionLine.c_str(), defines ? defines : "", body };
+
+    unsigned int shader = glCreateShader(type);
+    glShaderSource(shader, 3, parts, NULL);
+    glCompileShader(shader);
+
+    int success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        char infoLog[1024];
+        glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+        std::cerr << "ERROR::SHADER::" << (type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT")
+                  << "::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+    return shader;
+}
+
+inline bool CheckProgramLinked(unsigned int program, bool printLog)
+{
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success && printLog)
+    {
+        char infoLog[1024];
+        glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    }
+    return success != 0;
+}
+
+inline std::string ProgramCachePath(unsigned long long hash)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%016llx.bin", hash);
+    return std::string(kShaderCacheDir) + "/" + name;
+}
+
+// Returns 0 if there is no usable cache entry.
+inline unsigned int LoadProgramBinary(const std::string& path)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return 0;
+    GLenum format = 0;
+    std::vector<char> binary;
+    long size = 0;
+    if (fread(&format, sizeof(format), 1, file) == 1)
+    {
+        fseek(file, 0, SEEK_END);
+        size = ftell(file) - (long)sizeof(format);
+        fseek(file, sizeof(format), SEEK_SET);
+        if (size > 0)
+        {
+            binary.resize(size);
+            if (fread(binary.data(), 1, size, file) != (size_t)size)
+                binary.clear();
+        }
+    }
+    fclose(file);
+    if (binary.empty())
+        return 0;
+
+    unsigned int program = glCreateProgram();
+    glProgramBinary(program, format, binary.data(), (GLsizei)binary.size());
+    // a driver update or a different GPU makes the blob invalid - not an error, just a miss
+    if (!CheckProgramLinked(program, false))
+    {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+inline void SaveProgramBinary(unsigned int program, const std::string& path)
+{
+    int length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, NULL, &format, binary.data());
+
+    std::error_code error;
+    std::filesystem::create_directories(kShaderCacheDir, error);
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        fprintf(stderr, "WARNING: could not write shader cache %s\n", path.c_str());
+        return;
+    }
+    fwrite(&format, sizeof(format), 1, file);
+    fwrite(binary.data(), 1, binary.size(), file);
+    fclose(file);
+}
+
+// Builds (or loads from the cache) a program from a vertex and a fragment shader.
+// name is used for the startup report and as the object label.
+inline unsigned int LoadShaderProgram(const char* name, const char* vertexSource, const char* fragmentSource,
+                                      const char* defines = "", GL_SITE_PARAMS)
+{
+    auto start = std::chrono::steady_clock::now();
+    bool binarySupported = GLEW_ARB_get_program_binary;
+    unsigned long long hash = HashProgramSources(vertexSource, fragmentSource, defines);
+    std::string path = ProgramCachePath(hash);
+
+    unsigned int program = binarySupported ? LoadProgramBinary(path) : 0;
+    bool cacheHit = program != 0;
+    if (!cacheHit)
+    {
+        unsigned int vertexShader = CompileShaderStage(GL_VERTEX_SHADER, vertexSource, defines);
+        unsigned int fragmentShader = CompileShaderStage(GL_FRAGMENT_SHADER, fragmentSource, defines);
+        program = glCreateProgram();
+        if (binarySupported)
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glAttachShader(program, vertexShader);
+        glAttachShader(program, fragmentShader);
+        glLinkProgram(program);
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        if (CheckProgramLinked(program, true) && binarySupported)
+            SaveProgramBinary(program, path);
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("Program %s: %s in %.3f ms\n", name, cacheHit ? "loaded from cache" : "compiled", ms);
+    int binaryLength = 0;
+    if (binarySupported)
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    TrackGLObject(GL_PROGRAM, program, name, binaryLength, GL_SITE_ARGS);
+    return program;
+}
@@ -0,0 +1,219 @@
+// Sort-keyed render queue
+// Draws are submitted as small records with a 64-bit key, radix sorted once per frame
+// and executed while skipping every program / texture / VAO / cull state that is
+// already bound. Opaque draws are grouped by state (front-to-back inside a group),
+// transparent draws are ordered back-to-front first and by state second.
+#pragma once
+
+#include "GL/glew.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+struct DrawRecord
+{
+    unsigned long long key;
+    unsigned int program;
+    unsigned int vao;
+    unsigned int textures[2];   // units 0 and 1, 0 = don't care
+    GLenum mode;
+    int first, count;
+    GLenum indexType;           // 0 = glDrawArrays, else glDrawElements from the VAO's index buffer
+    GLenum cullFace;            // GL_BACK / GL_FRONT, 0 = culling disabled
+    int modelLocation;          // mat4 uniform, -1 = none
+    const float* model;         // must stay valid until Execute
+    int flagLocation;           // one int uniform (e.g. useTextureFlag), -1 = none
+    int flagValue;
+};
+
+struct RenderQueueStats
+{
+    unsigned int draws = 0;
+    unsigned int stateChanges = 0;         // binds actually issued
+    unsigned int stateChangesUnsorted = 0; // binds the submission order would have needed
+    double sortMicroseconds = 0.0;
+};
+
+struct RenderQueue
+{
+    std::vector<DrawRecord> records;
+    std::vector<unsigned long long> keys, keysTmp;
+    std::vector<unsigned int> order, orderTmp;
+    RenderQueueStats stats;
+};
+
+// pass: 0..7, depth: 0 = nearest .. 1 = farthest
+inline unsigned long long MakeSortKey(unsigned int pass, bool transparent, unsigned int program, GLenum cullFace,
+                                      unsigned int texture, unsigned int vao, float depth)
+{
+    if (depth < 0.0f) depth = 0.0f;
+    if (depth > 1.0f) depth = 1.0f;
+    unsigned long long d = (unsigned long long)(depth * 16777215.0f);
+    unsigned long long cull = cullFace == GL_BACK ? 1 : (cullFace == GL_FRONT ? 2 : 0);
+    unsigned long long key = (unsigned long long)(pass & 7) << 61;
+    if (!transparent)
+    {
+        key |= (unsigned long long)(program & 0x3ff) << 50;
+        key |= cull << 48;
+        key |= (unsigned long long)(texture & 0xfff) << 36;
+        key |= (unsigned long long)(vao & 0xfff) << 24;
+        key |= d;
+    }
+    else
+    {
+        key |= 1ull << 60;
+        key |= (0xffffffull - d) << 36; // back to front
+        key |= (unsigned long long)(program & 0x3ff) << 26;
+        key |= cull << 24;
+        key |= (unsigned long long)(texture & 0xfff) << 12;
+        key |= (unsigned long long)(vao & 0xfff);
+    }
+    return key;
+}
+
+inline void ClearRenderQueue(RenderQueue& queue)
+{
+    queue.records.clear();
+}
+
+inline void SubmitDraw(RenderQueue& queue, const DrawRecord& record)
+{
+    queue.records.push_back(record);
+}
+
+// LSD radix sort of (key, index) pairs, one byte per pass; passes where every key
+// has the same byte are skipped, which is most of them for small scenes.
+inline void SortRenderQueue(RenderQueue& queue)
+{
+    size_t n = queue.records.size();
+    queue.keys.resize(n);
+    queue.keysTmp.resize(n);
+    queue.order.resize(n);
+    queue.orderTmp.resize(n);
+
+    unsigned int histogram[8][256];
+    memset(histogram, 0, sizeof(histogram));
+    for (size_t i = 0; i < n; i++)
+    {
+        unsigned long long key = queue.records[i].key;
+        queue.keys[i] = key;
+        queue.order[i] = (unsigned int)i;
+        for (int b = 0; b < 8; b++)
+            histogram[b][(key >> (b * 8)) & 0xff]++;
+    }
+
+    for (int b = 0; b < 8; b++)
+    {
+        unsigned int* count = histogram[b];
+        if (n == 0 || count[(queue.keys[0] >> (b * 8)) & 0xff] == n)
+            continue;
+        unsigned int offset = 0;
+        for (int i = 0; i < 256; i++)
+        {
+            unsigned int c = count[i];
+            count[i] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            unsigned int slot = count[(queue.keys[i] >> (b * 8)) & 0xff]++;
+            queue.keysTmp[slot] = queue.keys[i];
+            queue.orderTmp[slot] = queue.order[i];
+        }
+        queue.keys.swap(queue.keysTmp);
+        queue.order.swap(queue.orderTmp);
+    }
+}
+
+// Bound state while walking the queue; also used to count what the unsorted order would cost.
+struct RenderQueueState
+{
+    unsigned int program = 0, vao = 0, textures[2] = { 0, 0 };
+    GLenum cullFace = 0;
+    const float* model = NULL;
+    int flagValue = -1;
+    bool first = true;
+};
+
+// Returns the number of binds needed to go from state to record (and updates state).
+inline unsigned int CountStateChanges(RenderQueueState& state, const DrawRecord& r)
+{
+    unsigned int changes = 0;
+    if (state.first || r.program != state.program) { changes++; state.program = r.program; state.model = NULL; state.flagValue = -1; }
+    if (state.first || r.vao != state.vao) { changes++; state.vao = r.vao; }
+    for (int unit = 0; unit < 2; unit++)
+        if (r.textures[unit] && r.textures[unit] != state.textures[unit]) { changes++; state.textures[unit] = r.textures[unit]; }
+    if (state.first || r.cullFace != state.cullFace) { changes++; state.cullFace = r.cullFace; }
+    state.first = false;
+    return changes;
+}
+
+inline void ExecuteRenderQueue(RenderQueue& queue)
+{
+    auto start = std::chrono::steady_clock::now();
+    SortRenderQueue(queue);
+    queue.stats.sortMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    RenderQueueState unsorted;
+    queue.stats.stateChangesUnsorted = 0;
+    for (const DrawRecord& r : queue.records)
+        queue.stats.stateChangesUnsorted += CountStateChanges(unsorted, r);
+
+    RenderQueueState state;
+    queue.stats.stateChanges = 0;
+    queue.stats.draws = (unsigned int)queue.records.size();
+    for (unsigned int index : queue.order)
+    {
+        const DrawRecord& r = queue.records[index];
+        if (state.first || r.program != state.program)
+            glUseProgram(r.program);
+        if (state.first || r.vao != state.vao)
+            glBindVertexArray(r.vao);
+        for (int unit = 0; unit < 2; unit++)
+        {
+            if (r.textures[unit] && r.textures[unit] != state.textures[unit])
+            {
+                glActiveTexture(GL_TEXTURE0 + unit);
+                glBindTexture(GL_TEXTURE_2D, r.textures[unit]);
+            }
+        }
+        if (state.first || r.cullFace != state.cullFace)
+        {
+            if (r.cullFace)
+            {
+                glEnable(GL_CULL_FACE);
+                glCullFace(r.cullFace);
+            }
+            else
+                glDisable(GL_CULL_FACE);
+        }
+        queue.stats.stateChanges += CountStateChanges(state, r);
+
+        if (r.modelLocation >= 0 && r.model != state.model)
+        {
+            glUniformMatrix4fv(r.modelLocation, 1, GL_FALSE, r.model);
+            state.model = r.model;
+        }
+        if (r.flagLocation >= 0 && r.flagValue != state.flagValue)
+        {
+            glUniform1i(r.flagLocation, r.flagValue);
+            state.flagValue = r.flagValue;
+        }
+        if (r.indexType)
+            glDrawElements(r.mode, r.count, r.indexType,
+                           (void*)((size_t)r.first * (r.indexType == GL_UNSIGNED_SHORT ? 2 : 4)));
+        else
+            glDrawArrays(r.mode, r.first, r.count);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+inline void PrintRenderQueueStats(const RenderQueue& queue, const char* name)
+{
+    const RenderQueueStats& s = queue.stats;
+    printf("%s: %u draws, %u state changes (%u unsorted, %d saved), sort %.2f us\n", name, s.draws,
+           s.stateChanges, s.stateChangesUnsorted, (int)s.stateChangesUnsorted - (int)s.stateChanges,
+           s.sortMicroseconds);
+}
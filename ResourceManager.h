@@ -0,0 +1,203 @@
+// Shared GL resources
+// Textures, programs and static vertex buffers are looked up by a content key (hash of
+// the file bytes, the shader sources, or the vertex bytes) and reference counted, so two
+// scenes in the same process that ask for the same data get the same GL object.
+// Every hit records the memory and the load time the second copy would have cost.
+#pragma once
+
+#include "GL/glew.h"
+#include "ProgramCache.h"
+#include "stb_image.h"
+
+#include <chrono>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+
+enum ResourceType
+{
+    RESOURCE_TEXTURE,
+    RESOURCE_PROGRAM,
+    RESOURCE_BUFFER,
+    RESOURCE_TYPE_COUNT
+};
+
+struct SharedResource
+{
+    ResourceType type;
+    unsigned int object;
+    int refs;
+    size_t bytes;        // GPU memory estimate
+    double loadMs;       // what creating it cost
+};
+
+struct ResourceStats
+{
+    unsigned int requests[RESOURCE_TYPE_COUNT] = {};
+    unsigned int hits[RESOURCE_TYPE_COUNT] = {};
+    size_t bytesSaved = 0;
+    double msSaved = 0.0;
+};
+
+inline std::unordered_map<unsigned long long, SharedResource> sharedResources;
+inline std::unordered_map<unsigned int, unsigned long long> sharedTextureKeys, sharedProgramKeys, sharedBufferKeys;
+inline ResourceStats resourceStats;
+
+inline double ResourceMilliseconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Returns the shared object for key, or 0 (and counts a request either way).
+inline unsigned int FindSharedResource(ResourceType type, unsigned long long key)
+{
+    resourceStats.requests[type]++;
+    auto found = sharedResources.find(key);
+    if (found == sharedResources.end())
+        return 0;
+    SharedResource& r = found->second;
+    r.refs++;
+    resourceStats.hits[type]++;
+    resourceStats.bytesSaved += r.bytes;
+    resourceStats.msSaved += r.loadMs;
+    return r.object;
+}
+
+inline void AddSharedResource(ResourceType type, unsigned long long key, unsigned int object, size_t bytes, double loadMs,
+                              std::unordered_map<unsigned int, unsigned long long>& keys)
+{
+    sharedResources[key] = { type, object, 1, bytes, loadMs };
+    keys[object] = key;
+}
+
+// Drops one reference; returns true when the caller held the last one (or the object was never
+// shared) and it must be deleted.
+inline bool ReleaseSharedResource(unsigned int object, std::unordered_map<unsigned int, unsigned long long>& keys)
+{
+    auto key = keys.find(object);
+    if (key == keys.end())
+        return true;
+    auto found = sharedResources.find(key->second);
+    if (found == sharedResources.end() || --found->second.refs > 0)
+        return false;
+    sharedResources.erase(found);
+    keys.erase(key);
+    return true;
+}
+
+// Loads an image file into a mipmapped, repeating, linearly filtered texture (the demos' settings).
+inline unsigned int AcquireTexture(const char* path, GL_SITE_PARAMS)
+{
+    auto start = std::chrono::steady_clock::now();
+    FILE* file = fopen(path, "rb");
+    std::vector<unsigned char> bytes;
+    if (file)
+    {
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        if (size > 0)
+        {
+            bytes.resize(size);
+            if (fread(bytes.data(), 1, size, file) != (size_t)size)
+                bytes.clear();
+        }
+        fclose(file);
+    }
+    if (bytes.empty())
+    {
+        std::cerr << "Failed to load texture " << path << std::endl;
+        return 0;
+    }
+
+    unsigned long long key = HashBytes(bytes.data(), bytes.size(), HashString("texture"));
+    if (unsigned int shared = FindSharedResource(RESOURCE_TEXTURE, key))
+        return shared;
+
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    int width = 0, height = 0, nrChannels = 0;
+    unsigned char* data = stbi_load_from_memory(bytes.data(), (int)bytes.size(), &width, &height, &nrChannels, 0);
+    size_t gpuBytes = 0;
+    if (data)
+    {
+        GLenum format = nrChannels == 4 ? GL_RGBA : (nrChannels == 1 ? GL_RED : GL_RGB);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        gpuBytes = GLImageBytes(format, width, height, true);
+    }
+    else
+    {
+        std::cerr << "Failed to load texture " << path << std::endl;
+    }
+    stbi_image_free(data);
+    TrackGLObject(GL_TEXTURE, texture, path, gpuBytes, GL_SITE_ARGS);
+
+    AddSharedResource(RESOURCE_TEXTURE, key, texture, gpuBytes, ResourceMilliseconds(start), sharedTextureKeys);
+    return texture;
+}
+
+inline void ReleaseTexture(unsigned int texture)
+{
+    if (ReleaseSharedResource(texture, sharedTextureKeys))
+        DeleteGLObjects(GL_TEXTURE, 1, &texture);
+}
+
+inline unsigned int AcquireProgram(const char* name, const char* vertexSource, const char* fragmentSource,
+                                   const char* defines = "", GL_SITE_PARAMS)
+{
+    auto start = std::chrono::steady_clock::now();
+    unsigned long long key = HashProgramSources(vertexSource, fragmentSource, defines);
+    if (unsigned int shared = FindSharedResource(RESOURCE_PROGRAM, key))
+        return shared;
+    unsigned int program = LoadShaderProgram(name, vertexSource, fragmentSource, defines, GL_SITE_ARGS);
+    int binaryLength = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    AddSharedResource(RESOURCE_PROGRAM, key, program, binaryLength, ResourceMilliseconds(start), sharedProgramKeys);
+    return program;
+}
+
+inline void ReleaseProgram(unsigned int program)
+{
+    if (ReleaseSharedResource(program, sharedProgramKeys))
+        DeleteGLObjects(GL_PROGRAM, 1, &program);
+}
+
+// Static vertex data: returns a GL_STATIC_DRAW buffer holding exactly these bytes.
+inline unsigned int AcquireBuffer(const void* data, size_t size, const char* label = "static buffer", GL_SITE_PARAMS)
+{
+    auto start = std::chrono::steady_clock::now();
+    unsigned long long key = HashBytes(data, size, HashString("buffer"));
+    if (unsigned int shared = FindSharedResource(RESOURCE_BUFFER, key))
+        return shared;
+    unsigned int buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
+    TrackGLObject(GL_BUFFER, buffer, label, size, GL_SITE_ARGS);
+    AddSharedResource(RESOURCE_BUFFER, key, buffer, size, ResourceMilliseconds(start), sharedBufferKeys);
+    return buffer;
+}
+
+inline void ReleaseBuffer(unsigned int buffer)
+{
+    if (ReleaseSharedResource(buffer, sharedBufferKeys))
+        DeleteGLObjects(GL_BUFFER, 1, &buffer);
+}
+
+inline void PrintResourceStats()
+{
+    const char* names[RESOURCE_TYPE_COUNT] = { "textures", "programs", "buffers" };
+    printf("Shared resources:");
+    for (int i = 0; i < RESOURCE_TYPE_COUNT; i++)
+        printf(" %s %u/%u reused", names[i], resourceStats.hits[i], resourceStats.requests[i]);
+    printf(" | %.1f KB and %.2f ms saved\n", resourceStats.bytesSaved / 1024.0, resourceStats.msSaved);
+}
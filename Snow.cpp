@@ -1,13 +1,33 @@
+#ifndef SCENE_HOST // the host counts heap allocations itself
+#define FRAME_ARENA_HEAP_COUNTER // --heap-check
+#endif
 #include "GL/glew.h" // include GLEW and new version of GL on Windows
 #include "GL/glfw3.h" // GLFW helper library
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
+#include "ResourceManager.h"
+#include "ProceduralMesh.h"
+#include "OverdrawView.h"
+#include "InputRecorder.h"
+#include "FrameCapture.h"
+#include "DynamicResolution.h"
+#include "PerfHud.h"
+#include "FrameArena.h"
+#include "TripleBuffer.h"
+#include "DemoKernels.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <iostream>
 #include <vector> 
 #include <random>
+#include <thread>
+namespace snow {
+
 int Wwidth0, Wheight0;
 
 //Shaders
@@ -42,34 +62,20 @@ unsigned int shaderProgram;
 
 void InitMyShaders()
 {
-    // vertex shader
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-    // fragment shader
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-    // link shaders
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    // delete shaders
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    // compile + link, or load the program binary cached by a previous run
+    shaderProgram = AcquireProgram("snow", vertexShaderSource, fragmentShaderSource);
 }
 
 
 //Objects in space (xmin,xmax,ymin,ymax)
 float xmin = -10, xmax = 10.0, ymin = -10.0, ymax = 10.0;
 
-float vertices[] = {
-    // Position        // Color
-    -rightrec, -toprec, 0.0f,  0.0f, 0.5f, 1.0f, // left-bottom, red
-    -rightrec,  toprec, 0.0f,  0.0f, 0.5f, 1.0f, // left-top, green
-     rightrec,  toprec, 0.0f,  0.0f, 0.5f, 1.0f, // right-top, blue
-     rightrec, -toprec, 0.0f,  0.0f, 0.5f, 1.0f  // right-bottom, yellow
+ColorVertex vertices[] = {
+    // Position                        // Color
+    { { -rightrec, -toprec, 0.0f }, { 0.0f, 0.5f, 1.0f } }, // left-bottom
+    { { -rightrec,  toprec, 0.0f }, { 0.0f, 0.5f, 1.0f } }, // left-top
+    { {  rightrec,  toprec, 0.0f }, { 0.0f, 0.5f, 1.0f } }, // right-top
+    { {  rightrec, -toprec, 0.0f }, { 0.0f, 0.5f, 1.0f } }  // right-bottom
 };
 //-----------------------------------------------------
 
@@ -80,19 +86,14 @@ void SetupVerticesData()
     // Generate and bind the Vertex Array Object first
     glGenVertexArrays(1, &VAO);
     glBindVertexArray(VAO);
+    GL_TRACK(GL_VERTEX_ARRAY, VAO, "snow rectangle", 0);
 
-    // Generate, bind, and set vertex buffer(s)
-    glGenBuffers(1, &VBO);
+    // Generate (or share), bind, and set vertex buffer(s)
+    VBO = AcquireBuffer(vertices, sizeof(vertices), "snow rectangle");
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    // Set up position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
 
-    // Set up color attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    // Set up position and color attributes
+    ColorLayout::Apply();
 }
 
 
@@ -125,45 +126,17 @@ void myInit()
     //-----------------------------------------    
 }
 // Circle properties
-const int num_segments = 100; // number of segments for the circle
-std::random_device rd;
-std::mt19937 gen(rd());
+std::mt19937 gen; // seeded in main from the input recorder, so --replay sees the same flakes
 //std::uniform_real_distribution<float> radiusdistribution(0.1, 0.5);
 //float randomrad = radiusdistribution(gen);
-float circleRadius = 0.3f; // radius of the circle
-float circleVertices[300]; // array to hold the circle's vertices
+float circleRadius = 0.3f; // radius of the circle, applied by the model matrix to the unit kCircle100
 float circlePosY = toprec - circleRadius; // initial position of the circle
 
 
 std::uniform_real_distribution<float> distribution(-rightrec,rightrec);
-float randomOffset=distribution(gen);
-//float randomOffset = (static_cast<float>(rand()) / static_cast<float>(RAND_MAX)) * (2.0f * rightrec) - rightrec;
-float circlePosX = rectanglePosX+randomOffset;
-
-// Function to generate the circle's vertices
-void generateCircleVertices() {
-    int index = 0;
-    float theta = 2.0f * 3.1415926f / float(num_segments);
-    float cos = cosf(theta);
-    float sin = sinf(theta);
-    float t;
-
-    float x = circleRadius;
-    float y = 0;
-
-    for (int ii = 0; ii < num_segments; ii++) {
-        circleVertices[index++] = x;
-        circleVertices[index++] = y;
-        circleVertices[index++] = 0.0f;
-
-        // apply rotation matrix
-        t = x;
-        x = cos * x - sin * y;
-        y = sin * t + cos * y;
-    }
-}
+float circlePosX; // rectanglePosX + random offset, set in main
 
-unsigned int circleVBO, circleVAO;
+unsigned int circleVAO, circleVBO;
 
 void SetupCircleData()
 {
@@ -172,54 +145,262 @@ void SetupCircleData()
     // Generate and bind the Vertex Array Object first, 
     glGenVertexArrays(1, &circleVAO);
     glBindVertexArray(circleVAO);
-    // Then generate and bind and set vertex buffer(s), and then configure vertex attributes(s).
-    glGenBuffers(1, &circleVBO);
+    GL_TRACK(GL_VERTEX_ARRAY, circleVAO, "snow flake", 0);
+    // Then the unit circle baked at build time, and then configure vertex attributes(s).
+    circleVBO = AcquireBuffer(kCircle100.data(), sizeof(kCircle100), "snow flake");
     glBindBuffer(GL_ARRAY_BUFFER, circleVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(circleVertices), circleVertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), 0);
-    glEnableVertexAttribArray(0);
+    PositionLayout::Apply();
 }
 
 
 void UpdateCirclePosition()
 {
-    // Update position based on speed
-    circlePosY -= 0.001f;
+    Flake flake = { circlePosX, circlePosY, circleRadius };
+    StepFlake(flake, rectanglePosX, rightrec, toprec, gen);
+    circlePosX = flake.x;
+    circlePosY = flake.y;
+    circleRadius = flake.radius;
+}
+
+// --sim-thread: the rectangle and the flake are stepped at kSimStepHz on a thread of their
+// own, so the next step is computed while the current frame is drawn. The render thread only
+// reads the newest finished snapshot out of a triple buffer; neither side ever waits.
+struct SnowSnapshot
+{
+    float rectanglePosX = 0.0f, circlePosX = 0.0f, circlePosY = 0.0f, circleRadius = 0.0f;
+    unsigned long long step = 0;
+    std::chrono::steady_clock::time_point time; // when the step finished
+};
+
+const double kSimStepHz = 60.0;
+
+struct SnowSimulation
+{
+    bool enabled = false;
+    std::thread thread;
+    std::atomic<bool> quit{ false };
+    std::atomic<bool> rendering{ false }; // the render thread is inside SceneFrame
+    TripleBuffer<SnowSnapshot> snapshots;
+
+    // simulation thread
+    unsigned long long steps = 0, overlappedSteps = 0;
+    double stepMicroseconds = 0.0;
+
+    // render thread
+    unsigned long long frames = 0, repeatedFrames = 0, skippedSteps = 0, lastStep = 0;
+    double ageMsSum = 0.0, ageMsMax = 0.0;
+};
+
+SnowSimulation simulation;
+
+SnowSnapshot SnapshotSnow(unsigned long long step)
+{
+    SnowSnapshot snapshot;
+    snapshot.rectanglePosX = rectanglePosX;
+    snapshot.circlePosX = circlePosX;
+    snapshot.circlePosY = circlePosY;
+    snapshot.circleRadius = circleRadius;
+    snapshot.step = step;
+    snapshot.time = std::chrono::steady_clock::now();
+    return snapshot;
+}
 
-    // Check if circle hits the bottom of the rectangle and reset position
-    if (circlePosY <= (-toprec + circleRadius))
+// Owns the simulation globals (and gen) while it runs.
+void SimulationMain()
+{
+    auto stepDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / kSimStepHz));
+    auto next = std::chrono::steady_clock::now();
+    while (!simulation.quit.load(std::memory_order_relaxed))
     {
-        circlePosY = toprec;
-        float randomOffset = distribution(gen);
-        circlePosX = rectanglePosX + randomOffset;
-        std::uniform_real_distribution<float> radiusdistribution(0.02, 0.2);
-        float randomrad = radiusdistribution(gen);
-        circleRadius = randomrad;
-
-        // Generate new vertices for the circle with the new radius
-        generateCircleVertices();
-
-        // Update the vertex buffer data with the new vertices
-        glBindBuffer(GL_ARRAY_BUFFER, circleVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(circleVertices), circleVertices, GL_STATIC_DRAW);
+        // a step counts as overlapped if a frame was being drawn when it started or ended
+        bool overlapped = simulation.rendering.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        UpdateRectanglePosition();
+        UpdateCirclePosition();
+        simulation.steps++;
+        TripleBufferWriteSlot(simulation.snapshots) = SnapshotSnow(simulation.steps);
+        PublishTripleBuffer(simulation.snapshots);
+        auto end = std::chrono::steady_clock::now();
+        if (overlapped || simulation.rendering.load(std::memory_order_relaxed))
+            simulation.overlappedSteps++;
+        simulation.stepMicroseconds += std::chrono::duration<double, std::micro>(end - start).count();
+
+        next += stepDuration;
+        if (next < end - 4 * stepDuration)
+            next = end; // far behind (suspended, debugger): carry on instead of catching up in a burst
+        std::this_thread::sleep_until(next);
     }
+}
 
-    if (circlePosX >= (rectanglePosX + rightrec))
+void StartSimulation()
+{
+    ResetTripleBuffer(simulation.snapshots, SnapshotSnow(0));
+    simulation.quit = false;
+    simulation.thread = std::thread(SimulationMain);
+}
+
+void StopSimulation()
+{
+    simulation.quit = true;
+    simulation.thread.join();
+    SnowSimulation& s = simulation;
+    printf("snow simulation: %llu steps at %.0f Hz, %.2f us per step, %.1f%% overlapped with rendering\n", s.steps,
+           kSimStepHz, s.steps ? s.stepMicroseconds / s.steps : 0.0, s.steps ? 100.0 * s.overlappedSteps / s.steps : 0.0);
+    printf("snow snapshots: %llu frames, age %.2f ms average / %.2f ms max, %llu frames repeated a step, "
+           "%llu steps never drawn\n",
+           s.frames, s.frames ? s.ageMsSum / s.frames : 0.0, s.ageMsMax, s.repeatedFrames, s.skippedSteps);
+}
+
+// The state the frame draws: the newest snapshot, or one step taken right here without --sim-thread.
+SnowSnapshot NextSnowState()
+{
+    if (!simulation.enabled)
     {
-        circlePosX = rectanglePosX - rightrec;
+        UpdateRectanglePosition();
+        UpdateCirclePosition();
+        return SnapshotSnow(0);
     }
-    else if (circlePosX <= (rectanglePosX - rightrec))
+    AcquireTripleBuffer(simulation.snapshots);
+    SnowSnapshot state = TripleBufferReadSlot(simulation.snapshots);
+    double ageMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - state.time).count();
+    simulation.frames++;
+    simulation.ageMsSum += ageMs;
+    if (ageMs > simulation.ageMsMax)
+        simulation.ageMsMax = ageMs;
+    if (state.step == simulation.lastStep)
+        simulation.repeatedFrames++;
+    else
+        simulation.skippedSteps += state.step - simulation.lastStep - 1;
+    simulation.lastStep = state.step;
+    return state;
+}
+
+OverdrawView overdraw; // --overdraw
+InputRecorder recorder; // --record / --replay / --timing / --headless
+
+// Scene entry points, used by main below and by scene_host.cpp
+void SceneInit(int width, int height, unsigned int seed)
+{
+    gen.seed(seed);
+    float randomOffset = distribution(gen);
+    circlePosX = rectanglePosX + randomOffset;
+
+    Wwidth0 = width;
+    Wheight0 = height;
+    InitMyShaders();
+    if (overdraw.enabled)
+    {
+        ReleaseProgram(shaderProgram);
+        shaderProgram = CreateOverdrawProgram(vertexShaderSource);
+        InitOverdrawView(overdraw, Wwidth0, Wheight0);
+    }
+    SetupVerticesData();
+    SetupCircleData(); // Setup the circle's VAO and VBO
+    myInit();
+    if (simulation.enabled)
+        StartSimulation();
+}
+
+void SceneFrame(double time)
+{
+    // state other scenes in the same context may have changed
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glClearColor(0.2, 0.2, 0.3, 0.0);
+    glUseProgram(shaderProgram);
+    simulation.rendering.store(true, std::memory_order_relaxed);
+
+    if (overdraw.enabled)
+        BeginOverdrawFrame(overdraw);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // Update the rectangle and circle positions (or take the simulation thread's newest step)
+    SnowSnapshot state = NextSnowState();
+
+    // Apply translation to the model matrix for the rectangle
+    glm::mat4 rectangleModelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(state.rectanglePosX, 0.0f, 0.0f));
+    int modelMatrixLocation = glGetUniformLocation(shaderProgram, "model");
+    glUniformMatrix4fv(modelMatrixLocation, 1, GL_FALSE, glm::value_ptr(rectangleModelMatrix));
+
+    // Draw rectangle
+    if (overdraw.enabled)
+        BeginOverdrawPass(overdraw, "rectangle");
+    glBindVertexArray(VAO);
+    glDrawArrays(GL_QUADS, 0, 4);
+    if (overdraw.enabled)
+        EndOverdrawPass(overdraw);
+
+    // Apply translation and the radius to the model matrix for the circle
+    glm::mat4 circleModelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(state.circlePosX, state.circlePosY, 0.0f));
+    circleModelMatrix = glm::scale(circleModelMatrix, glm::vec3(state.circleRadius, state.circleRadius, 1.0f));
+    glUniformMatrix4fv(modelMatrixLocation, 1, GL_FALSE, glm::value_ptr(circleModelMatrix));
+
+    // Draw circle
+    if (overdraw.enabled)
+        BeginOverdrawPass(overdraw, "flake");
+    glBindVertexArray(circleVAO);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, (GLsizei)kCircle100.size());
+    HudCountDraws(2);
+    if (overdraw.enabled)
     {
-        circlePosX = rectanglePosX + rightrec;
+        EndOverdrawPass(overdraw);
+        EndOverdrawFrame(overdraw, time);
     }
+    simulation.rendering.store(false, std::memory_order_relaxed);
+}
+
+void SceneShutdown()
+{
+    if (simulation.enabled)
+        StopSimulation();
+    DeleteGLObjects(GL_VERTEX_ARRAY, 1, &VAO);
+    DeleteGLObjects(GL_VERTEX_ARRAY, 1, &circleVAO);
+    ReleaseBuffer(VBO);
+    ReleaseBuffer(circleVBO);
+    ReleaseProgram(shaderProgram);
+    DestroyOverdrawView(overdraw);
 }
 
-int main(void) {
+} // namespace snow
+
+#ifndef SCENE_HOST
+int main(int argc, char** argv) {
+    using namespace snow;
+    const char* capturePath = NULL;
+    double dynresTarget = 0.0; // ms, 0 = off
+    const char* dynresLog = NULL;
+    bool hud = false;
+    bool checkHeap = false; // --heap-check: steady-state frames must not allocate
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--overdraw") == 0)
+            overdraw.enabled = true;
+        else if (strcmp(argv[i], "--sim-thread") == 0)
+            simulation.enabled = true;
+        else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+            capturePath = argv[++i];
+        else if (strcmp(argv[i], "--hud") == 0)
+            hud = true;
+        else if (strcmp(argv[i], "--heap-check") == 0)
+            checkHeap = true;
+        else if (strcmp(argv[i], "--dynres") == 0 && i + 1 < argc)
+        {
+            dynresTarget = atof(argv[++i]);
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                dynresLog = argv[++i];
+        }
+    }
+
     // start GL context and O/S window using the GLFW helper library
     if (!glfwInit()) {
         fprintf(stderr, "ERROR: could not start GLFW3\n");
         return 1;
     }
+    if (!InitInputRecorder(recorder, argc, argv)) {
+        glfwTerminate();
+        return 1;
+    }
 
     GLFWwindow* window = glfwCreateWindow(800, 800, "My Practice APP", NULL, NULL);
     if (!window) {
@@ -238,53 +419,63 @@ int main(void) {
     printf("Renderer: %s\n", renderer);
     printf("OpenGL version supported %s\n", version);
 
-    glfwGetWindowSize(window, &Wwidth0, &Wheight0); // Retrieves the size of the content area of the specified window.
-    printf("winow size %d x %d \n", Wwidth0, Wheight0);
+    int width, height;
+    glfwGetWindowSize(window, &width, &height); // Retrieves the size of the content area of the specified window.
+    printf("winow size %d x %d \n", width, height);
     srand(static_cast<unsigned int>(time(0)));
-    InitMyShaders();
-    SetupVerticesData();
-    generateCircleVertices(); // Generate the circle's vertices
-    SetupCircleData(); // Setup the circle's VAO and VBO
-    myInit();
+    if (simulation.enabled && recorder.mode == INPUT_REPLAY)
+    {
+        // the steps a frame sees depend on thread timing, which a replay cannot reproduce
+        fprintf(stderr, "--sim-thread is ignored with --replay\n");
+        simulation.enabled = false;
+    }
+    SceneInit(width, height, (unsigned int)recorder.seed);
+    FrameCapture capture;
+    if (capturePath && !InitFrameCapture(capture, capturePath, width, height))
+        return 1;
+    DynamicResolution dynres;
+    if (dynresTarget > 0.0 && !overdraw.enabled && !InitDynamicResolution(dynres, width, height, dynresTarget, dynresLog))
+        return 1;
+    if (hud && !InitPerfHud(width, height))
+        return 1;
+    PrintGLTotals("after init");
 
+    if (checkHeap)
+        BeginHeapCheck();
     /* Loop until the user closes the window */
     while (!glfwWindowShouldClose(window))
     {
 
         /* Render here */
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        // Update rectangle position
-        UpdateRectanglePosition();
-
-        // Apply translation to the model matrix for the rectangle
-        glm::mat4 rectangleModelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(rectanglePosX, 0.0f, 0.0f));
-        int modelMatrixLocation = glGetUniformLocation(shaderProgram, "model");
-        glUniformMatrix4fv(modelMatrixLocation, 1, GL_FALSE, glm::value_ptr(rectangleModelMatrix));
-
-        // Draw rectangle
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_QUADS, 0, 4);
-
-        // Update circle position
-        UpdateCirclePosition();
-
-        // Apply translation to the model matrix for the circle
-        glm::mat4 circleModelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(circlePosX, circlePosY, 0.0f));
-        glUniformMatrix4fv(modelMatrixLocation, 1, GL_FALSE, glm::value_ptr(circleModelMatrix));
-
-        // Draw circle
-        glBindVertexArray(circleVAO);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, num_segments);
+        double time = BeginInputFrame(recorder);
+        BeginHudFrame();
+        if (dynres.enabled)
+            BeginDynamicResolution(dynres);
+        BeginHudScope("scene");
+        SceneFrame(time);
+        EndHudScope();
+        if (dynres.enabled)
+            EndDynamicResolution(dynres);
+        DrawHud();
+        CaptureFrame(capture);
 
         glfwSwapBuffers(window);
-        glfwPollEvents();
+        PollInput(recorder, window);
+        CountFrameHeap();
     }
 
 
+    FinishFrameCapture(capture);
+    DestroyDynamicResolution(dynres);
+    DestroyPerfHud();
+    CloseInputRecorder(recorder);
+    SceneShutdown();
+    ReportGLLeaks();
+
     // close GL context and any other GLFW resources
     glfwTerminate();
-    return 0;
+    return EndHeapCheck() ? 0 : 1;
 }
+#endif
 
 
@@ -0,0 +1,144 @@
+// Streaming vertex buffer
+// One big GL buffer split into per-frame regions. Each frame writes only into its own
+// region through glMapBufferRange (unsynchronized + invalidate range), and a fence placed
+// at the end of the frame tells us when the GPU is done reading that region again.
+// Dynamic geometry goes through StreamUpload every frame instead of glBufferData.
+#pragma once
+
+#include "GL/glew.h"
+#include "GLTracker.h"
+
+#include <cstdio>
+#include <cstring>
+
+const int kMaxStreamRegions = 4;
+
+struct StreamBuffer
+{
+    unsigned int buffer = 0;
+    GLsizeiptr regionSize = 0;
+    int regionCount = 0;
+    int region = 0;           // region written by the current frame
+    GLsizeiptr head = 0;      // next free byte inside the current region
+    GLsync fences[kMaxStreamRegions] = {};
+
+    // statistics
+    unsigned int stalls = 0;           // frames that had to wait for the GPU
+    unsigned int frameStalls = 0;
+    GLsizeiptr bytesThisFrame = 0;
+    GLsizeiptr bytesLastFrame = 0;
+    unsigned long long bytesTotal = 0;
+    unsigned long long frames = 0;
+};
+
+// Creates the buffer storage once: regionCount regions of regionSize bytes each.
+inline void InitStreamBuffer(StreamBuffer& sb, GLsizeiptr regionSize, int regionCount = 3, GL_SITE_PARAMS)
+{
+    if (regionCount > kMaxStreamRegions)
+        regionCount = kMaxStreamRegions;
+    sb.regionSize = regionSize;
+    sb.regionCount = regionCount;
+    glGenBuffers(1, &sb.buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, sb.buffer);
+    glBufferData(GL_ARRAY_BUFFER, regionSize * regionCount, NULL, GL_STREAM_DRAW);
+    TrackGLObject(GL_BUFFER, sb.buffer, "stream buffer", regionSize * regionCount, GL_SITE_ARGS);
+}
+
+inline void DestroyStreamBuffer(StreamBuffer& sb)
+{
+    for (int i = 0; i < kMaxStreamRegions; i++)
+    {
+        if (sb.fences[i])
+            glDeleteSync(sb.fences[i]);
+        sb.fences[i] = 0;
+    }
+    DeleteGLObjects(GL_BUFFER, 1, &sb.buffer);
+    sb.buffer = 0;
+}
+
+// Call once at the start of a frame, before any allocation.
+// Waits (and counts a stall) only if the GPU still reads the region we are about to reuse.
+inline void BeginStreamFrame(StreamBuffer& sb)
+{
+    sb.head = 0;
+    sb.bytesThisFrame = 0;
+    sb.frameStalls = 0;
+    GLsync fence = sb.fences[sb.region];
+    if (!fence)
+        return;
+
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+        sb.stalls++;
+        sb.frameStalls++;
+        do
+        {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(fence);
+    sb.fences[sb.region] = 0;
+}
+
+// Call once after the last draw that reads from this frame's region.
+inline void EndStreamFrame(StreamBuffer& sb)
+{
+    sb.fences[sb.region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    sb.region = (sb.region + 1) % sb.regionCount;
+    sb.bytesLastFrame = sb.bytesThisFrame;
+    sb.bytesTotal += sb.bytesThisFrame;
+    sb.frames++;
+}
+
+// Sub-allocates size bytes aligned to alignment (any value, e.g. the vertex stride so the
+// result can be used as the "first" argument of glDrawArrays).
+// Returns the mapped pointer and the byte offset inside the buffer, or NULL if the region is full.
+// The buffer stays bound to GL_ARRAY_BUFFER; call StreamUnmap after writing.
+inline void* StreamAlloc(StreamBuffer& sb, GLsizeiptr size, GLsizeiptr alignment, GLintptr* offset)
+{
+    // align the offset inside the whole buffer: regionSize need not be a multiple of alignment
+    GLsizeiptr regionStart = sb.region * sb.regionSize;
+    GLsizeiptr start = sb.head;
+    if (alignment > 1)
+        start = (regionStart + start + alignment - 1) / alignment * alignment - regionStart;
+    if (start + size > sb.regionSize)
+    {
+        fprintf(stderr, "ERROR: stream buffer region full (%ld + %ld > %ld bytes)\n",
+                (long)start, (long)size, (long)sb.regionSize);
+        return NULL;
+    }
+    sb.head = start + size;
+    sb.bytesThisFrame += size;
+
+    *offset = regionStart + start;
+    glBindBuffer(GL_ARRAY_BUFFER, sb.buffer);
+    return glMapBufferRange(GL_ARRAY_BUFFER, *offset, size,
+                            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+}
+
+inline void StreamUnmap(StreamBuffer& sb)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, sb.buffer);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+}
+
+// Copies data into a fresh sub-allocation and returns its byte offset (-1 on failure).
+inline GLintptr StreamUpload(StreamBuffer& sb, const void* data, GLsizeiptr size, GLsizeiptr alignment)
+{
+    GLintptr offset = 0;
+    void* ptr = StreamAlloc(sb, size, alignment, &offset);
+    if (!ptr)
+        return -1;
+    memcpy(ptr, data, size);
+    StreamUnmap(sb);
+    return offset;
+}
+
+// Prints stall count and streamed bytes; meant to be called every few seconds.
+inline void PrintStreamStats(const StreamBuffer& sb, const char* name)
+{
+    double average = sb.frames ? (double)sb.bytesTotal / sb.frames : 0.0;
+    printf("%s: %llu frames, %u stalls, %ld bytes last frame, %.1f bytes/frame average\n",
+           name, sb.frames, sb.stalls, (long)sb.bytesLastFrame, average);
+}
@@ -0,0 +1,64 @@
+// Lock-free triple buffer
+// Hands whole snapshots from one writer thread to one reader thread without either ever
+// waiting on the other. The writer fills its private slot and swaps it with the shared
+// middle slot; the reader swaps its private slot with the middle one whenever a newer
+// snapshot is there. The reader always sees a complete snapshot, the newest one published;
+// snapshots it was too slow to take are overwritten.
+#pragma once
+
+#include <atomic>
+
+template <typename T>
+struct TripleBuffer
+{
+    static constexpr unsigned int kFresh = 4; // set in middle while it holds an unread snapshot
+
+    T slots[3] = {};
+    std::atomic<unsigned int> middle{ 1 };
+    unsigned int writeIndex = 0; // private to the writer
+    unsigned int readIndex = 2;  // private to the reader
+};
+
+// Before the threads start: every slot holds value, and nothing is marked fresh.
+template <typename T>
+inline void ResetTripleBuffer(TripleBuffer<T>& buffer, const T& value)
+{
+    for (T& slot : buffer.slots)
+        slot = value;
+    buffer.writeIndex = 0;
+    buffer.middle.store(1);
+    buffer.readIndex = 2;
+}
+
+// Writer: the slot to fill next.
+template <typename T>
+inline T& TripleBufferWriteSlot(TripleBuffer<T>& buffer)
+{
+    return buffer.slots[buffer.writeIndex];
+}
+
+// Writer: makes the filled slot the newest snapshot and takes the old middle slot to fill next.
+template <typename T>
+inline void PublishTripleBuffer(TripleBuffer<T>& buffer)
+{
+    buffer.writeIndex = buffer.middle.exchange(buffer.writeIndex | TripleBuffer<T>::kFresh, std::memory_order_acq_rel) & 3;
+}
+
+// Reader: takes the newest snapshot if one was published since the last call. Returns false
+// (and keeps the current one) otherwise.
+template <typename T>
+inline bool AcquireTripleBuffer(TripleBuffer<T>& buffer)
+{
+    // only the writer changes middle in between, and it only ever sets kFresh
+    if (!(buffer.middle.load(std::memory_order_relaxed) & TripleBuffer<T>::kFresh))
+        return false;
+    buffer.readIndex = buffer.middle.exchange(buffer.readIndex, std::memory_order_acq_rel) & 3;
+    return true;
+}
+
+// Reader: the snapshot taken by the last AcquireTripleBuffer.
+template <typename T>
+inline const T& TripleBufferReadSlot(const TripleBuffer<T>& buffer)
+{
+    return buffer.slots[buffer.readIndex];
+}
@@ -0,0 +1,141 @@
+// Typed vertex layouts
+// A layout names the vertex struct and its attributes in order; stride, offsets and the GL
+// type of every attribute are worked out by the compiler, and Apply() issues the
+// glVertexAttribPointer / glEnableVertexAttribArray calls for the bound VAO and buffer:
+//   using ColorLayout = VertexLayout<ColorVertex, Attrib<0, float, 3>, Attrib<1, float, 3>>;
+//   ColorLayout::Apply();
+// A layout that does not cover its struct exactly (a missing attribute, padding) does not compile.
+// Sizes alone do not catch attributes listed out of member order, so every layout is also
+// checked against the offsetof of the member each attribute reads:
+//   static_assert(ColorLayout::MatchesMembers({ offsetof(ColorVertex, position), offsetof(ColorVertex, color) }),
+//                 "ColorLayout does not follow ColorVertex");
+#pragma once
+
+#include "GL/glew.h"
+
+#include <cstddef>
+#include <initializer_list>
+#include <utility>
+
+template <typename T> struct GLComponentType;
+template <> struct GLComponentType<float> { static constexpr GLenum value = GL_FLOAT; };
+template <> struct GLComponentType<signed char> { static constexpr GLenum value = GL_BYTE; };
+template <> struct GLComponentType<unsigned char> { static constexpr GLenum value = GL_UNSIGNED_BYTE; };
+template <> struct GLComponentType<short> { static constexpr GLenum value = GL_SHORT; };
+template <> struct GLComponentType<unsigned short> { static constexpr GLenum value = GL_UNSIGNED_SHORT; };
+template <> struct GLComponentType<int> { static constexpr GLenum value = GL_INT; };
+template <> struct GLComponentType<unsigned int> { static constexpr GLenum value = GL_UNSIGNED_INT; };
+
+// One attribute: shader location, component type, component count, normalized (integer types only).
+template <unsigned int Location, typename Component, int Count, bool Normalized = false>
+struct Attrib
+{
+    static_assert(Count >= 1 && Count <= 4, "an attribute has 1 to 4 components");
+    static constexpr unsigned int location = Location;
+    static constexpr int count = Count;
+    static constexpr GLenum type = GLComponentType<Component>::value;
+    static constexpr GLboolean normalized = Normalized ? GL_TRUE : GL_FALSE;
+    static constexpr size_t size = sizeof(Component) * Count;
+};
+
+template <typename Vertex, typename... Attribs>
+struct VertexLayout
+{
+    static_assert((Attribs::size + ... + 0) == sizeof(Vertex),
+                  "the attributes must cover the vertex struct exactly");
+
+    static constexpr GLsizei stride = sizeof(Vertex);
+
+    // byte offset of attribute Index: the sizes of the ones before it
+    template <size_t Index>
+    static constexpr size_t Offset()
+    {
+        constexpr size_t sizes[] = { Attribs::size... };
+        size_t offset = 0;
+        for (size_t i = 0; i < Index; i++)
+            offset += sizes[i];
+        return offset;
+    }
+
+    // memberOffsets[i]: offsetof the member attribute i reads; false if any Offset<i>() differs.
+    static constexpr bool MatchesMembers(std::initializer_list<size_t> memberOffsets)
+    {
+        constexpr size_t sizes[] = { Attribs::size... };
+        if (memberOffsets.size() != sizeof...(Attribs))
+            return false;
+        size_t offset = 0, i = 0;
+        for (size_t memberOffset : memberOffsets)
+        {
+            if (memberOffset != offset)
+                return false;
+            offset += sizes[i++];
+        }
+        return true;
+    }
+
+    // baseOffset: where the first vertex starts in the bound GL_ARRAY_BUFFER
+    // divisor: 1 for per-instance data (glDrawArraysInstanced / glDrawElementsInstanced)
+    static void Apply(size_t baseOffset = 0, unsigned int divisor = 0)
+    {
+        ApplyAll(baseOffset, divisor, std::index_sequence_for<Attribs...>{});
+    }
+
+private:
+    template <size_t... Index>
+    static void ApplyAll(size_t baseOffset, unsigned int divisor, std::index_sequence<Index...>)
+    {
+        (ApplyOne<Attribs>(baseOffset + Offset<Index>(), divisor), ...);
+    }
+
+    template <typename A>
+    static void ApplyOne(size_t offset, unsigned int divisor)
+    {
+        if (A::type == GL_FLOAT || A::normalized)
+            glVertexAttribPointer(A::location, A::count, A::type, A::normalized, stride, (void*)offset);
+        else
+            glVertexAttribIPointer(A::location, A::count, A::type, stride, (void*)offset);
+        glEnableVertexAttribArray(A::location);
+        if (divisor)
+            glVertexAttribDivisor(A::location, divisor);
+    }
+};
+
+// The vertex formats the demos use, with their layouts.
+struct PositionVertex
+{
+    float position[3] = {};
+};
+
+struct ColorVertex
+{
+    float position[3] = {};
+    float color[3] = {};
+};
+
+struct TexturedVertex
+{
+    float position[3] = {};
+    float uv[2] = {};
+};
+
+struct MeshVertex
+{
+    float position[3] = {};
+    float normal[3] = {};
+    float uv[2] = {};
+};
+
+using PositionLayout = VertexLayout<PositionVertex, Attrib<0, float, 3>>;
+using ColorLayout = VertexLayout<ColorVertex, Attrib<0, float, 3>, Attrib<1, float, 3>>;
+using TexturedLayout = VertexLayout<TexturedVertex, Attrib<0, float, 3>, Attrib<1, float, 2>>;
+using MeshLayout = VertexLayout<MeshVertex, Attrib<0, float, 3>, Attrib<1, float, 3>, Attrib<2, float, 2>>;
+
+static_assert(PositionLayout::MatchesMembers({ offsetof(PositionVertex, position) }),
+              "PositionLayout does not follow PositionVertex");
+static_assert(ColorLayout::MatchesMembers({ offsetof(ColorVertex, position), offsetof(ColorVertex, color) }),
+              "ColorLayout does not follow ColorVertex");
+static_assert(TexturedLayout::MatchesMembers({ offsetof(TexturedVertex, position), offsetof(TexturedVertex, uv) }),
+              "TexturedLayout does not follow TexturedVertex");
+static_assert(MeshLayout::MatchesMembers({ offsetof(MeshVertex, position), offsetof(MeshVertex, normal),
+                                           offsetof(MeshVertex, uv) }),
+              "MeshLayout does not follow MeshVertex");
@@ -0,0 +1,194 @@
+// Vertex compression
+// Packs float position / uv / color streams into one interleaved, quantized stream:
+//   positions: half floats, or normalized shorts inside a bounds box
+//   uvs:       unorm16
+//   colors:    RGBA8 (unorm)
+// and produces the matching attribute setup (type, normalized flag, offset, stride).
+// Normalized-short positions come out in [-1, 1]; the vertex shader has to apply
+// QuantizedMesh::positionScale / positionBias to get the original coordinates back.
+#pragma once
+
+#include "GL/glew.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+enum PositionFormat
+{
+    POSITION_FLOAT,
+    POSITION_HALF,
+    POSITION_SNORM16
+};
+
+struct QuantizedAttrib
+{
+    unsigned int location;
+    int components;
+    GLenum type;
+    GLboolean normalized;
+    size_t offset;
+};
+
+struct QuantizedMesh
+{
+    std::vector<unsigned char> data; // interleaved vertices
+    QuantizedAttrib attribs[3];
+    int attribCount = 0;
+    int stride = 0;
+    int vertexCount = 0;
+    float positionScale[3] = { 1.0f, 1.0f, 1.0f };
+    float positionBias[3] = { 0.0f, 0.0f, 0.0f };
+};
+
+// float -> IEEE half, round to nearest even, no NaN payloads
+inline unsigned short FloatToHalf(float value)
+{
+    unsigned int f;
+    memcpy(&f, &value, 4);
+    unsigned int sign = (f >> 16) & 0x8000;
+    int exponent = (int)((f >> 23) & 0xff) - 127 + 15;
+    unsigned int mantissa = f & 0x7fffff;
+    if (((f >> 23) & 0xff) == 0xff)
+        return (unsigned short)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    if (exponent >= 31)
+        return (unsigned short)(sign | 0x7c00); // overflow -> inf
+    if (exponent <= 0)
+    {
+        if (exponent < -10)
+            return (unsigned short)sign;       // underflow -> 0
+        mantissa |= 0x800000;
+        unsigned int shift = 14 - exponent;
+        unsigned int half = mantissa >> shift;
+        unsigned int rest = mantissa & ((1u << shift) - 1);
+        unsigned int halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1)))
+            half++;
+        return (unsigned short)(sign | half);
+    }
+    unsigned int half = sign | (exponent << 10) | (mantissa >> 13);
+    unsigned int rest = mantissa & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+        half++; // may carry into the exponent, which is still correct
+    return (unsigned short)half;
+}
+
+inline unsigned short FloatToUnorm16(float value)
+{
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return (unsigned short)lroundf(value * 65535.0f);
+}
+
+inline short FloatToSnorm16(float value)
+{
+    value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+    return (short)lroundf(value * 32767.0f);
+}
+
+inline unsigned char FloatToUnorm8(float value)
+{
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return (unsigned char)lroundf(value * 255.0f);
+}
+
+inline size_t AlignTo4(size_t size)
+{
+    return (size + 3) & ~(size_t)3;
+}
+
+// positions: 3 floats per vertex (positionStride floats apart), uvs: 2 floats or NULL,
+// colors: 3 floats or NULL. Every input stream has its own stride in floats.
+inline QuantizedMesh QuantizeVertices(int vertexCount, PositionFormat format,
+                                      const float* positions, int positionStride,
+                                      const float* uvs, int uvStride,
+                                      const float* colors, int colorStride)
+{
+    QuantizedMesh mesh;
+    mesh.vertexCount = vertexCount;
+
+    // bounds box for snorm16
+    float lo[3] = { 0, 0, 0 }, hi[3] = { 0, 0, 0 };
+    for (int v = 0; v < vertexCount; v++)
+        for (int c = 0; c < 3; c++)
+        {
+            float p = positions[v * positionStride + c];
+            if (v == 0 || p < lo[c]) lo[c] = p;
+            if (v == 0 || p > hi[c]) hi[c] = p;
+        }
+    if (format == POSITION_SNORM16)
+        for (int c = 0; c < 3; c++)
+        {
+            mesh.positionBias[c] = 0.5f * (lo[c] + hi[c]);
+            mesh.positionScale[c] = hi[c] > lo[c] ? 0.5f * (hi[c] - lo[c]) : 1.0f;
+        }
+
+    size_t positionSize = format == POSITION_FLOAT ? 12 : 6;
+    size_t offset = 0;
+    GLenum positionType = format == POSITION_FLOAT ? GL_FLOAT : (format == POSITION_HALF ? GL_HALF_FLOAT : GL_SHORT);
+    mesh.attribs[mesh.attribCount++] = { 0, 3, positionType, (GLboolean)(format == POSITION_SNORM16), offset };
+    offset += AlignTo4(positionSize);
+    size_t uvOffset = offset;
+    if (uvs)
+    {
+        mesh.attribs[mesh.attribCount++] = { 1, 2, GL_UNSIGNED_SHORT, GL_TRUE, offset };
+        offset += 4;
+    }
+    size_t colorOffset = offset;
+    if (colors)
+    {
+        mesh.attribs[mesh.attribCount++] = { 2, 4, GL_UNSIGNED_BYTE, GL_TRUE, offset };
+        offset += 4;
+    }
+    mesh.stride = (int)offset;
+    mesh.data.assign((size_t)vertexCount * mesh.stride, 0);
+
+    for (int v = 0; v < vertexCount; v++)
+    {
+        unsigned char* out = mesh.data.data() + (size_t)v * mesh.stride;
+        const float* p = positions + v * positionStride;
+        if (format == POSITION_FLOAT)
+            memcpy(out, p, 12);
+        else
+            for (int c = 0; c < 3; c++)
+            {
+                unsigned short q = format == POSITION_HALF
+                    ? FloatToHalf(p[c])
+                    : (unsigned short)FloatToSnorm16((p[c] - mesh.positionBias[c]) / mesh.positionScale[c]);
+                memcpy(out + c * 2, &q, 2);
+            }
+        if (uvs)
+        {
+            unsigned short q[2] = { FloatToUnorm16(uvs[v * uvStride]), FloatToUnorm16(uvs[v * uvStride + 1]) };
+            memcpy(out + uvOffset, q, 4);
+        }
+        if (colors)
+        {
+            const float* c = colors + v * colorStride;
+            unsigned char q[4] = { FloatToUnorm8(c[0]), FloatToUnorm8(c[1]), FloatToUnorm8(c[2]), 255 };
+            memcpy(out + colorOffset, q, 4);
+        }
+    }
+    return mesh;
+}
+
+// Sets up the attribute pointers for the buffer bound to GL_ARRAY_BUFFER.
+inline void ApplyQuantizedLayout(const QuantizedMesh& mesh)
+{
+    for (int i = 0; i < mesh.attribCount; i++)
+    {
+        const QuantizedAttrib& a = mesh.attribs[i];
+        glVertexAttribPointer(a.location, a.components, a.type, a.normalized, mesh.stride, (void*)a.offset);
+        glEnableVertexAttribArray(a.location);
+    }
+}
+
+// Prints bytes per vertex against the float layout the data came from.
+inline void PrintQuantizeReport(const char* name, const QuantizedMesh& mesh, int floatsPerVertex)
+{
+    size_t before = (size_t)mesh.vertexCount * floatsPerVertex * sizeof(float);
+    size_t after = mesh.data.size();
+    printf("%s: %d vertices, %d -> %d bytes/vertex, %zu -> %zu bytes (%.0f%% less bandwidth)\n", name,
+           mesh.vertexCount, floatsPerVertex * (int)sizeof(float), mesh.stride, before, after,
+           before ? 100.0 * (1.0 - (double)after / before) : 0.0);
+}
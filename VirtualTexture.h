@@ -0,0 +1,618 @@
+// Virtual texturing (.vtex)
+// Layout on disk: VirtualTextureHeader | tiles, the tile blob aligned to kVirtualTextureAlignment.
+// The image is stored as a mip pyramid cut into tiles of tileSize x tileSize RGBA8 texels, each
+// padded with a border of its neighbours' texels so bilinear filtering never reads outside it.
+// Tiles are numbered level by level, row by row, all the same size, so tile i starts at
+// tileOffset + i * tile bytes. Files are written by img2vtex.cpp.
+//
+// At run time only the tiles the camera needs live on the GPU:
+//   feedback   the scene is drawn once more into a small integer target with
+//              CreateVirtualFeedbackProgram, which writes the page (x, y, level) every pixel
+//              samples; the target is read back through a pair of PBOs a frame later
+//   cache      a fixed grid of tile slots in one texture, refilled LRU first, straight from
+//              the memory-mapped file with glTexSubImage2D (kVirtualUploadsPerFrame at most)
+//   indirection  one texel per page of every level: the slot holding it, or the slot of its
+//              nearest resident ancestor (the single top-level tile is always resident)
+// Fragment shaders get SampleVirtualTexture(uv) from VirtualTextureFragmentSource.
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const char kVirtualTextureMagic[4] = { 'V', 'T', 'X', '1' };
+const uint32_t kVirtualTextureVersion = 1;
+const uint32_t kVirtualTextureAlignment = 4096;
+const int kVirtualTextureMaxLevels = 16;
+
+struct VirtualTextureLevel
+{
+    uint32_t width, height; // texels
+    uint32_t pagesX, pagesY;
+    uint32_t firstTile;
+};
+
+struct VirtualTextureHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t width, height; // level 0
+    uint32_t tileSize;      // texels per side, without the border
+    uint32_t border;
+    uint32_t levelCount;
+    uint32_t tileCount;
+    uint64_t tileOffset;
+    VirtualTextureLevel levels[kVirtualTextureMaxLevels];
+};
+
+// Fills in the levels, down to the first one that fits in a single tile. width, height,
+// tileSize and border must be set.
+inline void SetupVirtualTextureLevels(VirtualTextureHeader& h)
+{
+    h.levelCount = 0;
+    h.tileCount = 0;
+    for (int level = 0; level < kVirtualTextureMaxLevels; level++)
+    {
+        VirtualTextureLevel& l = h.levels[level];
+        l.width = h.width >> level ? h.width >> level : 1;
+        l.height = h.height >> level ? h.height >> level : 1;
+        l.pagesX = (l.width + h.tileSize - 1) / h.tileSize;
+        l.pagesY = (l.height + h.tileSize - 1) / h.tileSize;
+        l.firstTile = h.tileCount;
+        h.tileCount += l.pagesX * l.pagesY;
+        h.levelCount++;
+        if (l.pagesX == 1 && l.pagesY == 1)
+            break;
+    }
+}
+
+inline uint32_t VirtualTilePadded(const VirtualTextureHeader& h)
+{
+    return h.tileSize + 2 * h.border;
+}
+
+inline uint64_t VirtualTileBytes(const VirtualTextureHeader& h)
+{
+    return (uint64_t)VirtualTilePadded(h) * VirtualTilePadded(h) * 4;
+}
+
+struct VirtualTextureFile
+{
+    const VirtualTextureHeader* header = NULL;
+    const unsigned char* tiles = NULL;
+
+    // mapping
+    void* base = NULL;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE, mapping = NULL;
+#endif
+};
+
+inline void CloseVirtualTextureFile(VirtualTextureFile& vtex)
+{
+#ifdef _WIN32
+    if (vtex.base) UnmapViewOfFile(vtex.base);
+    if (vtex.mapping) CloseHandle(vtex.mapping);
+    if (vtex.file != INVALID_HANDLE_VALUE) CloseHandle(vtex.file);
+    vtex.mapping = NULL;
+    vtex.file = INVALID_HANDLE_VALUE;
+#else
+    if (vtex.base) munmap(vtex.base, vtex.size);
+#endif
+    vtex.base = NULL;
+    vtex.size = 0;
+    vtex.header = NULL;
+    vtex.tiles = NULL;
+}
+
+// Maps the file read-only and validates the header; tiles are paged in when they are first uploaded.
+inline bool OpenVirtualTextureFile(const char* path, VirtualTextureFile& vtex)
+{
+#ifdef _WIN32
+    vtex.file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (vtex.file == INVALID_HANDLE_VALUE)
+    {
+        fprintf(stderr, "ERROR: could not open virtual texture %s\n", path);
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(vtex.file, &fileSize);
+    vtex.size = (size_t)fileSize.QuadPart;
+    vtex.mapping = vtex.size ? CreateFileMappingA(vtex.file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    vtex.base = vtex.mapping ? MapViewOfFile(vtex.mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "ERROR: could not open virtual texture %s\n", path);
+        return false;
+    }
+    struct stat st;
+    fstat(fd, &st);
+    vtex.size = (size_t)st.st_size;
+    vtex.base = vtex.size ? mmap(NULL, vtex.size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+    if (vtex.base == MAP_FAILED)
+        vtex.base = NULL;
+    close(fd); // the mapping keeps the file alive
+#endif
+    if (!vtex.base || vtex.size < sizeof(VirtualTextureHeader))
+    {
+        fprintf(stderr, "ERROR: could not map virtual texture %s\n", path);
+        CloseVirtualTextureFile(vtex);
+        return false;
+    }
+
+    const VirtualTextureHeader* h = (const VirtualTextureHeader*)vtex.base;
+    VirtualTextureHeader expected = *h;
+    if (h->tileSize > 0 && h->width > 0 && h->height > 0)
+        SetupVirtualTextureLevels(expected);
+    if (memcmp(h->magic, kVirtualTextureMagic, 4) != 0 || h->version != kVirtualTextureVersion ||
+        h->tileSize == 0 || h->tileSize > 1024 || h->border > 8 || h->width == 0 || h->height == 0 ||
+        h->levelCount != expected.levelCount || h->tileCount != expected.tileCount ||
+        memcmp(h->levels, expected.levels, sizeof(h->levels)) != 0 ||
+        h->levels[h->levelCount - 1].pagesX != 1 || h->levels[h->levelCount - 1].pagesY != 1 || // top level is one tile
+        h->tileOffset % kVirtualTextureAlignment != 0 || h->tileOffset > vtex.size ||
+        (uint64_t)h->tileCount * VirtualTileBytes(*h) > vtex.size - h->tileOffset)
+    {
+        fprintf(stderr, "ERROR: %s is not a valid version %u virtual texture\n", path, kVirtualTextureVersion);
+        CloseVirtualTextureFile(vtex);
+        return false;
+    }
+    vtex.header = h;
+    vtex.tiles = (const unsigned char*)vtex.base + h->tileOffset;
+#ifndef _WIN32
+    madvise(vtex.base, vtex.size, MADV_RANDOM);
+#endif
+    return true;
+}
+
+inline const unsigned char* VirtualTextureTile(const VirtualTextureFile& vtex, uint32_t tile)
+{
+    return vtex.tiles + tile * VirtualTileBytes(*vtex.header);
+}
+
+#ifdef GLEW_VERSION
+#include "GLTracker.h"
+#include "ProgramCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+const int kVirtualFeedbackDivisor = 8;  // feedback target is the viewport / 8 on each side
+const int kVirtualUploadsPerFrame = 16; // tiles streamed per frame at most; the rest wait
+const unsigned int kVirtualPinned = ~0u;
+const uint32_t kVirtualNoTile = ~0u;
+
+// Shared by SampleVirtualTexture and the feedback shader, so both pick the same level and page.
+const char* const virtualTextureGLSL = "uniform sampler2D vtCache;\n"
+                                       "uniform sampler2D vtIndirection;\n"
+                                       "uniform vec2 vtLevelSize[16];\n"
+                                       "uniform int vtLevelRow[16];\n"
+                                       "uniform int vtLevelCount;\n"
+                                       "uniform float vtTileSize;\n"
+                                       "uniform float vtPaddedTile;\n"
+                                       "uniform float vtBorder;\n"
+                                       "uniform vec2 vtCacheSize;\n"
+                                       "uniform float vtLodBias;\n"
+                                       "int VirtualLevel(vec2 uv)\n"
+                                       "{\n"
+                                       "    vec2 texel = uv * vtLevelSize[0];\n"
+                                       "    vec2 dx = dFdx(texel), dy = dFdy(texel);\n"
+                                       "    float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + vtLodBias;\n"
+                                       "    return clamp(int(floor(lod + 0.5)), 0, vtLevelCount - 1);\n"
+                                       "}\n"
+                                       "ivec2 VirtualPage(vec2 uv, int level)\n"
+                                       "{\n"
+                                       "    vec2 pages = ceil(vtLevelSize[level] / vtTileSize);\n"
+                                       "    return ivec2(min(floor(uv * vtLevelSize[level] / vtTileSize), pages - 1.0));\n"
+                                       "}\n"
+                                       "vec4 SampleVirtualTexture(vec2 uv)\n"
+                                       "{\n"
+                                       "    uv = clamp(uv, 0.0, 1.0);\n"
+                                       "    int level = VirtualLevel(uv);\n"
+                                       "    ivec2 page = VirtualPage(uv, level);\n"
+                                       "    vec4 entry = texelFetch(vtIndirection, ivec2(page.x, vtLevelRow[level] + page.y), 0) * 255.0;\n"
+                                       "    int resident = int(entry.b + 0.5);\n"
+                                       "    vec2 within = uv * vtLevelSize[resident] / vtTileSize - vec2(VirtualPage(uv, resident));\n"
+                                       "    vec2 texel = floor(entry.rg + 0.5) * vtPaddedTile + vtBorder + within * vtTileSize;\n"
+                                       "    return textureLod(vtCache, texel / vtCacheSize, 0.0);\n"
+                                       "}\n";
+
+// The demo's vertex shader must output "TexCoord".
+const char* const virtualFeedbackFragmentSource = "#version 330 core\n"
+                                                  "in vec2 TexCoord;\n"
+                                                  "out uvec4 Feedback;\n"
+                                                  "void main()\n"
+                                                  "{\n"
+                                                  "    vec2 uv = clamp(TexCoord, 0.0, 1.0);\n"
+                                                  "    int level = VirtualLevel(uv);\n"
+                                                  "    Feedback = uvec4(uvec2(VirtualPage(uv, level)), uint(level), 1u);\n"
+                                                  "}\n";
+
+// A fragment shader with the sampling functions inserted after its #version line.
+inline std::string VirtualTextureFragmentSource(const char* source)
+{
+    const char* body = strchr(source, '\n');
+    body = body ? body + 1 : source + strlen(source);
+    return std::string(source, body) + virtualTextureGLSL + body;
+}
+
+struct VirtualTextureStats
+{
+    unsigned long long requests = 0, hits = 0, uploads = 0, evictions = 0, deferred = 0;
+};
+
+struct VirtualTexture
+{
+    bool enabled = false;
+    const VirtualTextureFile* file = NULL;
+    int slotsPerSide = 0, padded = 0;
+    unsigned int cacheTexture = 0, indirectionTexture = 0;
+    int cacheSize = 0, indirectionWidth = 0, indirectionHeight = 0;
+    int levelRow[kVirtualTextureMaxLevels] = {};
+    std::vector<unsigned char> indirection; // CPU copy, RGBA8: slot x, slot y, level, 255
+    bool indirectionDirty = true;
+
+    std::vector<int> tileSlot;             // per tile of the file: its cache slot, or -1
+    std::vector<uint32_t> slotTile;        // per slot: its tile, or kVirtualNoTile
+    std::vector<unsigned int> slotUsed;    // frame the slot was last requested, kVirtualPinned = never evict
+
+    // feedback
+    int feedbackWidth = 0, feedbackHeight = 0;
+    int feedbackViewport[2] = {}; // size of the last feedback pass
+    unsigned int feedbackFbo = 0, feedbackTexture = 0;
+    unsigned int feedbackPbos[2] = {};
+    GLsync feedbackFences[2] = {};
+    int feedbackSize[2][2] = {};  // viewport read into each PBO
+    GLint previousFramebuffers[2] = {}; // draw, read
+    GLint viewport[4] = {};
+    GLboolean scissor = GL_FALSE;
+    std::vector<uint32_t> requests;
+
+    unsigned int frame = 1; // slotUsed 0 = free
+    VirtualTextureStats stats;
+};
+
+// Copies one tile of the file into a cache slot.
+inline void UploadVirtualTile(VirtualTexture& vt, uint32_t tile, int slot)
+{
+    int x = slot % vt.slotsPerSide * vt.padded, y = slot / vt.slotsPerSide * vt.padded;
+    glBindTexture(GL_TEXTURE_2D, vt.cacheTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, vt.padded, vt.padded, GL_RGBA, GL_UNSIGNED_BYTE,
+                    VirtualTextureTile(*vt.file, tile));
+    if (vt.slotTile[slot] != kVirtualNoTile)
+    {
+        vt.tileSlot[vt.slotTile[slot]] = -1;
+        vt.stats.evictions++;
+    }
+    vt.slotTile[slot] = tile;
+    vt.tileSlot[tile] = slot;
+    vt.indirectionDirty = true;
+}
+
+// slotsPerSide^2 tiles in the cache (at most 256 per side: the indirection stores slots in bytes).
+inline bool InitVirtualTexture(VirtualTexture& vt, const VirtualTextureFile& file, int windowWidth, int windowHeight,
+                               int slotsPerSide = 16)
+{
+    const VirtualTextureHeader& h = *file.header;
+    vt.file = &file;
+    vt.slotsPerSide = std::min(slotsPerSide, 256);
+    vt.padded = (int)VirtualTilePadded(h);
+    vt.cacheSize = vt.slotsPerSide * vt.padded;
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    if (vt.cacheSize > maxSize)
+    {
+        fprintf(stderr, "ERROR: virtual texture cache %dx%d exceeds GL_MAX_TEXTURE_SIZE %d\n", vt.cacheSize,
+                vt.cacheSize, maxSize);
+        return false;
+    }
+
+    glGenTextures(1, &vt.cacheTexture);
+    glBindTexture(GL_TEXTURE_2D, vt.cacheTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, vt.cacheSize, vt.cacheSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    GL_TRACK(GL_TEXTURE, vt.cacheTexture, "virtual texture cache",
+             GLImageBytes(GL_RGBA8, vt.cacheSize, vt.cacheSize, false));
+
+    // one row block per level, level 0 on top
+    vt.indirectionWidth = (int)h.levels[0].pagesX;
+    vt.indirectionHeight = 0;
+    for (uint32_t level = 0; level < h.levelCount; level++)
+    {
+        vt.levelRow[level] = vt.indirectionHeight;
+        vt.indirectionHeight += (int)h.levels[level].pagesY;
+    }
+    vt.indirection.assign((size_t)vt.indirectionWidth * vt.indirectionHeight * 4, 0);
+    glGenTextures(1, &vt.indirectionTexture);
+    glBindTexture(GL_TEXTURE_2D, vt.indirectionTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, vt.indirectionWidth, vt.indirectionHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    GL_TRACK(GL_TEXTURE, vt.indirectionTexture, "virtual texture indirection",
+             GLImageBytes(GL_RGBA8, vt.indirectionWidth, vt.indirectionHeight, false));
+
+    int slots = vt.slotsPerSide * vt.slotsPerSide;
+    vt.tileSlot.assign(h.tileCount, -1);
+    vt.slotTile.assign(slots, kVirtualNoTile);
+    vt.slotUsed.assign(slots, 0);
+    UploadVirtualTile(vt, h.tileCount - 1, 0); // the top level: every page falls back to it
+    vt.slotUsed[0] = kVirtualPinned;
+
+    vt.feedbackWidth = std::max(1, windowWidth / kVirtualFeedbackDivisor);
+    vt.feedbackHeight = std::max(1, windowHeight / kVirtualFeedbackDivisor);
+    glGenTextures(1, &vt.feedbackTexture);
+    glBindTexture(GL_TEXTURE_2D, vt.feedbackTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16UI, vt.feedbackWidth, vt.feedbackHeight, 0, GL_RGBA_INTEGER,
+                 GL_UNSIGNED_SHORT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    GL_TRACK(GL_TEXTURE, vt.feedbackTexture, "virtual texture feedback",
+             (size_t)vt.feedbackWidth * vt.feedbackHeight * 8);
+    glGenFramebuffers(1, &vt.feedbackFbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, vt.feedbackFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, vt.feedbackTexture, 0);
+    GL_TRACK(GL_FRAMEBUFFER, vt.feedbackFbo, "virtual texture feedback", 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete)
+    {
+        fprintf(stderr, "ERROR: virtual texture feedback framebuffer is incomplete\n");
+        return false;
+    }
+
+    GLsizeiptr readbackBytes = (GLsizeiptr)vt.feedbackWidth * vt.feedbackHeight * 8;
+    glGenBuffers(2, vt.feedbackPbos);
+    for (unsigned int pbo : vt.feedbackPbos)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, readbackBytes, NULL, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    TrackGLObjects(GL_BUFFER, 2, vt.feedbackPbos, "virtual texture readback", readbackBytes, __FILE__, __LINE__);
+    vt.enabled = true;
+    return true;
+}
+
+// Binds the sampling uniforms of a program built from VirtualTextureFragmentSource or
+// CreateVirtualFeedbackProgram. The cache and indirection textures go on these units.
+inline void SetVirtualTextureUniforms(const VirtualTexture& vt, unsigned int program, int cacheUnit, int indirectionUnit,
+                                      float lodBias = 0.0f)
+{
+    const VirtualTextureHeader& h = *vt.file->header;
+    float levelSize[kVirtualTextureMaxLevels * 2] = {};
+    for (uint32_t level = 0; level < h.levelCount; level++)
+    {
+        levelSize[level * 2] = (float)h.levels[level].width;
+        levelSize[level * 2 + 1] = (float)h.levels[level].height;
+    }
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "vtCache"), cacheUnit);
+    glUniform1i(glGetUniformLocation(program, "vtIndirection"), indirectionUnit);
+    glUniform2fv(glGetUniformLocation(program, "vtLevelSize"), kVirtualTextureMaxLevels, levelSize);
+    glUniform1iv(glGetUniformLocation(program, "vtLevelRow"), kVirtualTextureMaxLevels, vt.levelRow);
+    glUniform1i(glGetUniformLocation(program, "vtLevelCount"), (int)h.levelCount);
+    glUniform1f(glGetUniformLocation(program, "vtTileSize"), (float)h.tileSize);
+    glUniform1f(glGetUniformLocation(program, "vtPaddedTile"), (float)vt.padded);
+    glUniform1f(glGetUniformLocation(program, "vtBorder"), (float)h.border);
+    glUniform2f(glGetUniformLocation(program, "vtCacheSize"), (float)vt.cacheSize, (float)vt.cacheSize);
+    glUniform1f(glGetUniformLocation(program, "vtLodBias"), lodBias);
+}
+
+// The demo's vertex shader with the page-writing fragment shader. The derivatives of the
+// reduced feedback target are kVirtualFeedbackDivisor times larger, hence the bias.
+inline unsigned int CreateVirtualFeedbackProgram(const VirtualTexture& vt, const char* vertexSource, GL_SITE_PARAMS)
+{
+    std::string fragmentSource = VirtualTextureFragmentSource(virtualFeedbackFragmentSource);
+    unsigned int program = LoadShaderProgram("virtual texture feedback", vertexSource, fragmentSource.c_str(), "",
+                                             GL_SITE_ARGS);
+    SetVirtualTextureUniforms(vt, program, 0, 0, -std::log2((float)kVirtualFeedbackDivisor));
+    return program;
+}
+
+// Redirects the following draws (made with the feedback program) into the feedback target.
+inline void BeginVirtualFeedback(VirtualTexture& vt)
+{
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &vt.previousFramebuffers[0]);
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &vt.previousFramebuffers[1]);
+    glGetIntegerv(GL_VIEWPORT, vt.viewport);
+    vt.scissor = glIsEnabled(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, vt.feedbackFbo);
+    glDisable(GL_SCISSOR_TEST);
+    vt.feedbackViewport[0] = std::min(vt.feedbackWidth, std::max(1, vt.viewport[2] / kVirtualFeedbackDivisor));
+    vt.feedbackViewport[1] = std::min(vt.feedbackHeight, std::max(1, vt.viewport[3] / kVirtualFeedbackDivisor));
+    glViewport(0, 0, vt.feedbackViewport[0], vt.feedbackViewport[1]);
+    const GLuint none[4] = { 0, 0, 0, 0 };
+    glClearBufferuiv(GL_COLOR, 0, none);
+}
+
+// Turns last frame's feedback into page requests: hits refresh their slot first, so no miss
+// can evict a tile this frame still asks for; misses are then streamed in (coarse levels
+// first, so fallbacks improve fastest) until the frame's budget or the free slots run out.
+inline void ServiceVirtualRequests(VirtualTexture& vt, const unsigned short* pixels, int width, int height)
+{
+    const VirtualTextureHeader& h = *vt.file->header;
+    vt.requests.clear();
+    for (int i = 0; i < width * height; i++)
+    {
+        const unsigned short* p = pixels + i * 4;
+        if (p[3] == 0 || p[2] >= h.levelCount)
+            continue;
+        const VirtualTextureLevel& level = h.levels[p[2]];
+        if (p[0] < level.pagesX && p[1] < level.pagesY)
+            vt.requests.push_back(level.firstTile + p[1] * level.pagesX + p[0]);
+    }
+    std::sort(vt.requests.begin(), vt.requests.end());
+    vt.requests.erase(std::unique(vt.requests.begin(), vt.requests.end()), vt.requests.end());
+
+    for (uint32_t tile : vt.requests)
+    {
+        vt.stats.requests++;
+        int slot = vt.tileSlot[tile];
+        if (slot < 0)
+            continue;
+        vt.stats.hits++;
+        if (vt.slotUsed[slot] != kVirtualPinned)
+            vt.slotUsed[slot] = vt.frame;
+    }
+
+    int uploads = 0;
+    for (auto it = vt.requests.rbegin(); it != vt.requests.rend(); ++it) // tiles are numbered fine to coarse
+    {
+        if (vt.tileSlot[*it] >= 0)
+            continue;
+        // least recently used slot that this frame has not asked for
+        int victim = -1;
+        for (int s = 0; s < (int)vt.slotUsed.size(); s++)
+            if (vt.slotUsed[s] < vt.frame && (victim < 0 || vt.slotUsed[s] < vt.slotUsed[victim]))
+                victim = s;
+        if (uploads == kVirtualUploadsPerFrame || victim < 0)
+        {
+            vt.stats.deferred++;
+            continue;
+        }
+        UploadVirtualTile(vt, *it, victim);
+        vt.slotUsed[victim] = vt.frame;
+        vt.stats.uploads++;
+        uploads++;
+    }
+}
+
+// Every page points at its own slot or inherits its parent's, coarsest level first.
+inline void UpdateVirtualIndirection(VirtualTexture& vt)
+{
+    const VirtualTextureHeader& h = *vt.file->header;
+    for (int level = (int)h.levelCount - 1; level >= 0; level--)
+    {
+        const VirtualTextureLevel& l = h.levels[level];
+        for (uint32_t y = 0; y < l.pagesY; y++)
+            for (uint32_t x = 0; x < l.pagesX; x++)
+            {
+                unsigned char* entry = &vt.indirection[((size_t)(vt.levelRow[level] + y) * vt.indirectionWidth + x) * 4];
+                int slot = vt.tileSlot[l.firstTile + y * l.pagesX + x];
+                if (slot >= 0)
+                {
+                    entry[0] = (unsigned char)(slot % vt.slotsPerSide);
+                    entry[1] = (unsigned char)(slot / vt.slotsPerSide);
+                    entry[2] = (unsigned char)level;
+                    entry[3] = 255;
+                }
+                else
+                {
+                    const VirtualTextureLevel& parent = h.levels[level + 1];
+                    uint32_t px = std::min(x / 2, parent.pagesX - 1), py = std::min(y / 2, parent.pagesY - 1);
+                    memcpy(entry, &vt.indirection[((size_t)(vt.levelRow[level + 1] + py) * vt.indirectionWidth + px) * 4], 4);
+                }
+            }
+    }
+    glBindTexture(GL_TEXTURE_2D, vt.indirectionTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, vt.indirectionWidth, vt.indirectionHeight, GL_RGBA, GL_UNSIGNED_BYTE,
+                    vt.indirection.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    vt.indirectionDirty = false;
+}
+
+// Restores the framebuffer, starts this frame's readback and services the previous one's,
+// if the GPU has finished it (never waits).
+inline void EndVirtualFeedback(VirtualTexture& vt)
+{
+    int current = vt.frame % 2, previous = 1 - current;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, vt.feedbackPbos[current]);
+    glReadPixels(0, 0, vt.feedbackViewport[0], vt.feedbackViewport[1], GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, 0);
+    if (vt.feedbackFences[current])
+        glDeleteSync(vt.feedbackFences[current]);
+    vt.feedbackFences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    vt.feedbackSize[current][0] = vt.feedbackViewport[0];
+    vt.feedbackSize[current][1] = vt.feedbackViewport[1];
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, vt.previousFramebuffers[0]);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, vt.previousFramebuffers[1]);
+    glViewport(vt.viewport[0], vt.viewport[1], vt.viewport[2], vt.viewport[3]);
+    if (vt.scissor)
+        glEnable(GL_SCISSOR_TEST);
+
+    GLsync fence = vt.feedbackFences[previous];
+    if (fence && glClientWaitSync(fence, 0, 0) != GL_TIMEOUT_EXPIRED)
+    {
+        glDeleteSync(fence);
+        vt.feedbackFences[previous] = 0;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, vt.feedbackPbos[previous]);
+        int width = vt.feedbackSize[previous][0], height = vt.feedbackSize[previous][1];
+        const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)width * height * 8, GL_MAP_READ_BIT);
+        if (pixels)
+        {
+            ServiceVirtualRequests(vt, (const unsigned short*)pixels, width, height);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (vt.indirectionDirty)
+        UpdateVirtualIndirection(vt);
+    vt.frame++;
+}
+
+// Binds the cache and indirection textures for drawing; leaves unit 0 active.
+inline void BindVirtualTexture(const VirtualTexture& vt, int cacheUnit, int indirectionUnit)
+{
+    glActiveTexture(GL_TEXTURE0 + cacheUnit);
+    glBindTexture(GL_TEXTURE_2D, vt.cacheTexture);
+    glActiveTexture(GL_TEXTURE0 + indirectionUnit);
+    glBindTexture(GL_TEXTURE_2D, vt.indirectionTexture);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+inline void PrintVirtualTextureStats(const VirtualTexture& vt, const char* name)
+{
+    const VirtualTextureHeader& h = *vt.file->header;
+    const VirtualTextureStats& s = vt.stats;
+    int resident = 0;
+    for (uint32_t tile : vt.slotTile)
+        resident += tile != kVirtualNoTile;
+    size_t cacheBytes = GLImageBytes(GL_RGBA8, vt.cacheSize, vt.cacheSize, false);
+    size_t indirectionBytes = GLImageBytes(GL_RGBA8, vt.indirectionWidth, vt.indirectionHeight, false);
+    printf("%s: %ux%u, %u levels, %u tiles; %d/%zu slots used, cache %.1f MB + indirection %.1f KB "
+           "(full upload %.1f MB)\n",
+           name, h.width, h.height, h.levelCount, h.tileCount, resident, vt.slotTile.size(), cacheBytes / 1048576.0,
+           indirectionBytes / 1024.0, GLImageBytes(GL_RGBA8, (int)h.width, (int)h.height, true) / 1048576.0);
+    printf("%s: %llu page requests, %.1f%% hits, %llu tiles streamed (%.1f MB), %llu evicted, %llu deferred\n", name,
+           s.requests, s.requests ? 100.0 * s.hits / s.requests : 0.0, s.uploads,
+           s.uploads * VirtualTileBytes(h) / 1048576.0, s.evictions, s.deferred);
+}
+
+inline void DestroyVirtualTexture(VirtualTexture& vt)
+{
+    if (!vt.enabled)
+        return;
+    for (GLsync& fence : vt.feedbackFences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+        fence = 0;
+    }
+    DeleteGLObjects(GL_BUFFER, 2, vt.feedbackPbos);
+    DeleteGLObjects(GL_FRAMEBUFFER, 1, &vt.feedbackFbo);
+    DeleteGLObjects(GL_TEXTURE, 1, &vt.feedbackTexture);
+    DeleteGLObjects(GL_TEXTURE, 1, &vt.indirectionTexture);
+    DeleteGLObjects(GL_TEXTURE, 1, &vt.cacheTexture);
+    vt.enabled = false;
+}
+#endif
@@ -0,0 +1,173 @@
+// Weighted blended order-independent transparency (McGuire & Bavoil 2013)
+// Between BeginWeightedOIT and ResolveWeightedOIT the demo draws its transparent geometry in
+// any order, with a fragment shader that writes two targets instead of a blended color:
+//   layout (location = 0) out vec4 accum;       // vec4(color.rgb * w, color.a)
+//   layout (location = 1) out float accumWeight; // w
+//   with w = color.a * clamp(kWeightedOITScale * pow(1.0 - gl_FragCoord.z, 3.0), 1e-2, kWeightedOITScale)
+// GL 3.3 has no per-target blend functions (glBlendFunci is 4.0), so both targets share
+//   glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA)
+// which sums rgb in both and multiplies the accum alpha by (1 - a): that alpha is the
+// revealage (how much of the background still shows), cleared to 1. The weight target is
+// R32F and has no alpha to disturb. ResolveWeightedOIT draws one full-screen triangle that
+// averages the colors (accum.rgb / accumWeight) and blends the result over the framebuffer
+// that was bound at Begin with coverage 1 - revealage.
+// The targets have no depth buffer: nothing opaque occludes the transparent layers.
+#pragma once
+
+#include "GL/glew.h"
+#include "GLTracker.h"
+#include "ProgramCache.h"
+
+#include <cstdio>
+
+// Depth weight scale; the paper uses 3e3 with half-float targets and few layers per pixel.
+// The sums grow with about layers x alpha x scale: 16384 layers at alpha 0.3 already reach
+// ~1.2e5 at scale 100, past the half-float maximum of 65504, so both targets are 32-bit float.
+const float kWeightedOITScale = 100.0f;
+
+const char* const weightedOITResolveVertexSource = "#version 330 core\n"
+                                                   "void main()\n"
+                                                   "{\n"
+                                                   "    vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+                                                   "    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);\n"
+                                                   "}\n\0";
+
+const char* const weightedOITResolveFragmentSource = "#version 330 core\n"
+                                                     "uniform sampler2D accumTexture;\n"
+                                                     "uniform sampler2D weightTexture;\n"
+                                                     "uniform ivec2 origin;\n"
+                                                     "out vec4 FragColor;\n"
+                                                     "void main()\n"
+                                                     "{\n"
+                                                     "    ivec2 texel = ivec2(gl_FragCoord.xy) - origin;\n"
+                                                     "    vec4 accum = texelFetch(accumTexture, texel, 0);\n"
+                                                     "    float revealage = accum.a;\n"
+                                                     "    if (revealage >= 1.0)\n"
+                                                     "        discard;\n"
+                                                     "    float weight = texelFetch(weightTexture, texel, 0).r;\n"
+                                                     "    FragColor = vec4(accum.rgb / max(weight, 1e-5), 1.0 - revealage);\n"
+                                                     "}\n\0";
+
+struct WeightedOIT
+{
+    bool enabled = false;
+    int width = 0, height = 0;
+    unsigned int fbo = 0, accumTexture = 0, weightTexture = 0;
+    unsigned int resolveProgram = 0, emptyVAO = 0;
+    int originLocation = -1;
+
+    // restored by ResolveWeightedOIT
+    GLint previousFramebuffer = 0;
+    GLint viewport[4] = {};
+    GLboolean scissor = GL_FALSE, depthTest = GL_FALSE;
+};
+
+// width x height: the largest viewport the transparent pass will be drawn with.
+inline bool InitWeightedOIT(WeightedOIT& oit, int width, int height)
+{
+    oit.width = width;
+    oit.height = height;
+
+    glGenTextures(1, &oit.accumTexture);
+    glBindTexture(GL_TEXTURE_2D, oit.accumTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    GL_TRACK(GL_TEXTURE, oit.accumTexture, "OIT accumulation", GLImageBytes(GL_RGBA32F, width, height, false));
+
+    glGenTextures(1, &oit.weightTexture);
+    glBindTexture(GL_TEXTURE_2D, oit.weightTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, width, height, 0, GL_RED, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    GL_TRACK(GL_TEXTURE, oit.weightTexture, "OIT weight", GLImageBytes(GL_R32F, width, height, false));
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &oit.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, oit.fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, oit.accumTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, oit.weightTexture, 0);
+    const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, drawBuffers);
+    GL_TRACK(GL_FRAMEBUFFER, oit.fbo, "OIT targets", 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete)
+    {
+        fprintf(stderr, "ERROR: OIT framebuffer is incomplete\n");
+        return false;
+    }
+
+    glGenVertexArrays(1, &oit.emptyVAO);
+    glBindVertexArray(oit.emptyVAO);
+    GL_TRACK(GL_VERTEX_ARRAY, oit.emptyVAO, "OIT resolve", 0);
+    glBindVertexArray(0);
+    oit.resolveProgram = LoadShaderProgram("OIT resolve", weightedOITResolveVertexSource,
+                                           weightedOITResolveFragmentSource);
+    glUseProgram(oit.resolveProgram);
+    glUniform1i(glGetUniformLocation(oit.resolveProgram, "accumTexture"), 0);
+    glUniform1i(glGetUniformLocation(oit.resolveProgram, "weightTexture"), 1);
+    oit.originLocation = glGetUniformLocation(oit.resolveProgram, "origin");
+    oit.enabled = true;
+    return true;
+}
+
+// Redirects the draws into the OIT targets, cleared, with the accumulation blend set up.
+// The viewport keeps its size but moves to the corner of the targets (scene_host draws
+// every scene at an offset), so the projection the demo set up still applies.
+inline void BeginWeightedOIT(WeightedOIT& oit)
+{
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &oit.previousFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, oit.viewport);
+    oit.scissor = glIsEnabled(GL_SCISSOR_TEST);
+    oit.depthTest = glIsEnabled(GL_DEPTH_TEST);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, oit.fbo);
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_DEPTH_TEST);
+    glViewport(0, 0, oit.viewport[2] < oit.width ? oit.viewport[2] : oit.width,
+               oit.viewport[3] < oit.height ? oit.viewport[3] : oit.height);
+    const float clearAccum[4] = { 0.0f, 0.0f, 0.0f, 1.0f }; // revealage starts at 1
+    const float clearWeight[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    glClearBufferfv(GL_COLOR, 0, clearAccum);
+    glClearBufferfv(GL_COLOR, 1, clearWeight);
+
+    glEnable(GL_BLEND);
+    glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+// Composites the accumulated layers over the framebuffer bound at Begin and restores its state.
+// Leaves the usual glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA) behind.
+inline void ResolveWeightedOIT(WeightedOIT& oit)
+{
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, oit.previousFramebuffer);
+    glViewport(oit.viewport[0], oit.viewport[1], oit.viewport[2], oit.viewport[3]);
+    if (oit.scissor)
+        glEnable(GL_SCISSOR_TEST);
+
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glUseProgram(oit.resolveProgram);
+    glUniform2i(oit.originLocation, oit.viewport[0], oit.viewport[1]);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, oit.accumTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, oit.weightTexture);
+    glBindVertexArray(oit.emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE0);
+    if (oit.depthTest)
+        glEnable(GL_DEPTH_TEST);
+}
+
+inline void DestroyWeightedOIT(WeightedOIT& oit)
+{
+    if (!oit.enabled)
+        return;
+    DeleteGLObjects(GL_PROGRAM, 1, &oit.resolveProgram);
+    DeleteGLObjects(GL_VERTEX_ARRAY, 1, &oit.emptyVAO);
+    DeleteGLObjects(GL_FRAMEBUFFER, 1, &oit.fbo);
+    DeleteGLObjects(GL_TEXTURE, 1, &oit.accumTexture);
+    DeleteGLObjects(GL_TEXTURE, 1, &oit.weightTexture);
+    oit.enabled = false;
+}
@@ -0,0 +1,113 @@
+// Persistent worker threads for CPU-side frame work
+// ParallelFor splits [0, count) into one contiguous range per thread (the calling
+// thread takes the first range) and returns when every range is done. Workers never
+// touch GL; the caller keeps the context.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef void (*WorkerJob)(void* context, int worker, int begin, int end);
+
+struct WorkerPool
+{
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    unsigned long long generation = 0;
+    bool quit = false;
+
+    // current job, published by bumping generation
+    WorkerJob job = NULL;
+    void* context = NULL;
+    int count = 0;
+    std::atomic<int> pending{ 0 };
+};
+
+inline int WorkerThreadCount(const WorkerPool& pool)
+{
+    return (int)pool.threads.size() + 1; // workers + calling thread
+}
+
+inline void RunWorkerRange(WorkerPool& pool, int worker)
+{
+    int threads = WorkerThreadCount(pool);
+    int begin = (int)((long long)pool.count * worker / threads);
+    int end = (int)((long long)pool.count * (worker + 1) / threads);
+    if (begin < end)
+        pool.job(pool.context, worker, begin, end);
+}
+
+inline void WorkerMain(WorkerPool* pool, int worker)
+{
+    unsigned long long seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            pool->wake.wait(lock, [&] { return pool->quit || pool->generation != seen; });
+            if (pool->quit)
+                return;
+            seen = pool->generation;
+        }
+        RunWorkerRange(*pool, worker);
+        if (pool->pending.fetch_sub(1) == 1)
+        {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+            pool->done.notify_one();
+        }
+    }
+}
+
+// workers = extra threads; 0 picks hardware_concurrency - 1.
+inline void StartWorkerPool(WorkerPool& pool, int workers = 0)
+{
+    if (workers <= 0)
+    {
+        int cores = (int)std::thread::hardware_concurrency();
+        workers = cores > 1 ? cores - 1 : 0;
+    }
+    for (int i = 0; i < workers; i++)
+        pool.threads.emplace_back(WorkerMain, &pool, i + 1);
+}
+
+inline void StopWorkerPool(WorkerPool& pool)
+{
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.quit = true;
+    }
+    pool.wake.notify_all();
+    for (std::thread& t : pool.threads)
+        t.join();
+    pool.threads.clear();
+}
+
+inline void ParallelFor(WorkerPool& pool, int count, WorkerJob job, void* context)
+{
+    pool.job = job;
+    pool.context = context;
+    pool.count = count;
+    int workers = (int)pool.threads.size();
+    if (workers > 0)
+    {
+        pool.pending = workers;
+        {
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            pool.generation++;
+        }
+        pool.wake.notify_all();
+    }
+
+    RunWorkerRange(pool, 0);
+
+    if (workers > 0)
+    {
+        std::unique_lock<std::mutex> lock(pool.mutex);
+        pool.done.wait(lock, [&] { return pool.pending.load() == 0; });
+    }
+}
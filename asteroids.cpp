@@ -0,0 +1,591 @@
+//Asteroid belt stress scene: a textured sun and earth and 100k+ instanced asteroids.
+//Every frame each asteroid gets a level of detail from its projected size on screen
+//(three sphere meshes baked by ProceduralMesh.h), the smallest ones are drawn as
+//camera-facing impostor quads, and the triangles submitted are reported once per second
+//next to what the same frame would cost without LOD.
+//  --asteroids N     instance count (default 100000)
+//  --no-lod          every asteroid at the highest level
+//  --no-impostors    the lowest sphere level instead of impostors
+#ifndef SCENE_HOST // the host counts heap allocations itself
+#define FRAME_ARENA_HEAP_COUNTER // --heap-check
+#endif
+#include "GL/glew.h" // include GLEW and new version of GL on Windows
+#include "GL/glfw3.h" // GLFW helper library
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/type_ptr.hpp"
+#include "ResourceManager.h"
+#include "ProceduralMesh.h"
+#include "StreamBuffer.h"
+#include "FrameCapture.h"
+#include "DynamicResolution.h"
+#include "PerfHud.h"
+#include "FrameArena.h"
+
+#ifndef SCENE_HOST // the host compiles stb_image itself
+#define STB_IMAGE_IMPLEMENTATION
+#endif
+#include "stb_image.h" // for texture loading
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace asteroids {
+
+// window size
+unsigned int Wwidth0 = 800, Wheight0 = 800;
+
+// Shaders
+// Spheres: per-instance position/scale (location 3) and spin axis/phase (location 4).
+// The sun and the earth use the same shader with constant values for those two.
+const char* sphereVertexSource = "#version 330 core\n"
+                                 "layout (location = 0) in vec3 aPos;\n"
+                                 "layout (location = 1) in vec3 aNormal;\n"
+                                 "layout (location = 2) in vec2 aTexCoord;\n"
+                                 "layout (location = 3) in vec4 aInstance;\n"
+                                 "layout (location = 4) in vec4 aSpin;\n"
+                                 "out vec3 Normal;\n"
+                                 "out vec3 WorldPos;\n"
+                                 "out vec2 TexCoord;\n"
+                                 "uniform mat4 projection;\n"
+                                 "uniform mat4 view;\n"
+                                 "uniform mat4 model;\n"
+                                 "uniform float time;\n"
+                                 "vec3 rotate(vec3 v, vec3 axis, float angle)\n"
+                                 "{\n"
+                                 "    return v * cos(angle) + cross(axis, v) * sin(angle) + axis * dot(axis, v) * (1.0 - cos(angle));\n"
+                                 "}\n"
+                                 "void main()\n"
+                                 "{\n"
+                                 "    float angle = aSpin.w + time;\n"
+                                 "    vec4 world = model * vec4(rotate(aPos, aSpin.xyz, angle) * aInstance.w + aInstance.xyz, 1.0);\n"
+                                 "    Normal = mat3(model) * rotate(aNormal, aSpin.xyz, angle);\n"
+                                 "    WorldPos = world.xyz;\n"
+                                 "    TexCoord = aTexCoord;\n"
+                                 "    gl_Position = projection * view * world;\n"
+                                 "}\0";
+
+const char* sphereFragmentSource = "#version 330 core\n"
+                                   "in vec3 Normal;\n"
+                                   "in vec3 WorldPos;\n"
+                                   "in vec2 TexCoord;\n"
+                                   "uniform sampler2D surface;\n"
+                                   "uniform bool emissive;\n"
+                                   "uniform vec3 sunPosition;\n"
+                                   "out vec4 FragColor;\n"
+                                   "void main()\n"
+                                   "{\n"
+                                   "    vec3 color = texture(surface, TexCoord).rgb;\n"
+                                   "    if (emissive)\n"
+                                   "    {\n"
+                                   "        FragColor = vec4(color, 1.0);\n"
+                                   "        return;\n"
+                                   "    }\n"
+                                   "    float diffuse = max(dot(normalize(Normal), normalize(sunPosition - WorldPos)), 0.0);\n"
+                                   "    FragColor = vec4(color * (0.15 + 0.85 * diffuse), 1.0);\n"
+                                   "}\0";
+
+// Impostors: a quad facing the camera, shaded as the sphere it stands for.
+const char* impostorVertexSource = "#version 330 core\n"
+                                   "layout (location = 0) in vec3 aPos;\n"
+                                   "layout (location = 1) in vec2 aTexCoord;\n"
+                                   "layout (location = 3) in vec4 aInstance;\n"
+                                   "layout (location = 4) in vec4 aSpin;\n"
+                                   "out vec2 Corner;\n"
+                                   "out vec2 TexCoord;\n"
+                                   "out vec3 CenterWorld;\n"
+                                   "uniform mat4 projection;\n"
+                                   "uniform mat4 view;\n"
+                                   "uniform mat4 model;\n"
+                                   "void main()\n"
+                                   "{\n"
+                                   "    vec4 world = model * vec4(aInstance.xyz, 1.0);\n"
+                                   "    Corner = aPos.xy * 2.0;\n"
+                                   "    TexCoord = aTexCoord * 0.5 + fract(aSpin.w) * 0.5;\n"
+                                   "    CenterWorld = world.xyz;\n"
+                                   "    gl_Position = projection * (view * world + vec4(Corner * aInstance.w, 0.0, 0.0));\n"
+                                   "}\0";
+
+const char* impostorFragmentSource = "#version 330 core\n"
+                                     "in vec2 Corner;\n"
+                                     "in vec2 TexCoord;\n"
+                                     "in vec3 CenterWorld;\n"
+                                     "uniform sampler2D surface;\n"
+                                     "uniform mat3 cameraToWorld;\n"
+                                     "uniform vec3 sunPosition;\n"
+                                     "out vec4 FragColor;\n"
+                                     "void main()\n"
+                                     "{\n"
+                                     "    float r2 = dot(Corner, Corner);\n"
+                                     "    if (r2 > 1.0)\n"
+                                     "        discard;\n"
+                                     "    vec3 normal = cameraToWorld * vec3(Corner, sqrt(1.0 - r2));\n"
+                                     "    float diffuse = max(dot(normal, normalize(sunPosition - CenterWorld)), 0.0);\n"
+                                     "    FragColor = vec4(texture(surface, TexCoord).rgb * (0.15 + 0.85 * diffuse), 1.0);\n"
+                                     "}\0";
+
+unsigned int sphereProgram, impostorProgram;
+
+void InitMyShaders()
+{
+    // compile + link, or load the program binary cached by a previous run
+    sphereProgram = AcquireProgram("asteroids sphere", sphereVertexSource, sphereFragmentSource);
+    impostorProgram = AcquireProgram("asteroids impostor", impostorVertexSource, impostorFragmentSource);
+}
+
+// Per-instance data, streamed every frame grouped by level of detail
+struct AsteroidInstance
+{
+    float position[3]; // in the belt's frame
+    float scale;
+    float axis[3];     // spin axis, unit length
+    float phase;
+};
+using InstanceLayout = VertexLayout<AsteroidInstance, Attrib<3, float, 4>, Attrib<4, float, 4>>;
+static_assert(InstanceLayout::MatchesMembers({ offsetof(AsteroidInstance, position), offsetof(AsteroidInstance, axis) }),
+              "InstanceLayout does not follow AsteroidInstance");
+
+// Levels of detail: three sphere meshes, then impostors
+const int kLodLevels = 4;
+const int kImpostorLevel = 3;
+const float kLodMinPixels[kLodLevels - 1] = { 24.0f, 8.0f, 2.5f }; // projected diameter to keep a level
+const char* const kLodNames[kLodLevels] = { "high", "medium", "low", "impostor" };
+
+struct LodMesh
+{
+    unsigned int VAO, VBO, EBO;
+    int indexCount;
+};
+LodMesh lods[kLodLevels]; // the impostor level has no EBO, its VAO draws kUnitQuad
+unsigned int planetVAO;   // the high sphere without instance attributes
+
+unsigned int earthTexture, sunTexture, asteroidTexture;
+
+template <int Stacks, int Slices>
+void SetupSphereLod(LodMesh& lod, const SphereMesh<Stacks, Slices>& mesh, const char* label)
+{
+    glGenVertexArrays(1, &lod.VAO);
+    glBindVertexArray(lod.VAO);
+    GL_TRACK(GL_VERTEX_ARRAY, lod.VAO, label, 0);
+    lod.VBO = AcquireBuffer(mesh.vertices.data(), sizeof(mesh.vertices), label);
+    glBindBuffer(GL_ARRAY_BUFFER, lod.VBO);
+    MeshLayout::Apply();
+    lod.EBO = AcquireBuffer(mesh.indices.data(), sizeof(mesh.indices), label);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lod.EBO);
+    lod.indexCount = (int)mesh.indices.size();
+}
+
+void SetupVerticesData()
+{
+    SetupSphereLod(lods[0], kSphereHigh, "asteroid high");
+    SetupSphereLod(lods[1], kSphereMedium, "asteroid medium");
+    SetupSphereLod(lods[2], kSphereLow, "asteroid low");
+
+    LodMesh& impostor = lods[kImpostorLevel];
+    glGenVertexArrays(1, &impostor.VAO);
+    glBindVertexArray(impostor.VAO);
+    GL_TRACK(GL_VERTEX_ARRAY, impostor.VAO, "asteroid impostor", 0);
+    impostor.VBO = AcquireBuffer(kUnitQuad.data(), sizeof(kUnitQuad), "asteroid impostor");
+    glBindBuffer(GL_ARRAY_BUFFER, impostor.VBO);
+    TexturedLayout::Apply();
+    impostor.EBO = 0;
+    impostor.indexCount = (int)kUnitQuad.size();
+
+    // the sun and the earth: same buffers as the high level (shared by AcquireBuffer)
+    glGenVertexArrays(1, &planetVAO);
+    glBindVertexArray(planetVAO);
+    GL_TRACK(GL_VERTEX_ARRAY, planetVAO, "planet", 0);
+    glBindBuffer(GL_ARRAY_BUFFER, AcquireBuffer(kSphereHigh.vertices.data(), sizeof(kSphereHigh.vertices), "planet"));
+    MeshLayout::Apply();
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, AcquireBuffer(kSphereHigh.indices.data(), sizeof(kSphereHigh.indices), "planet"));
+    glBindVertexArray(0);
+
+    // Load (or share) textures, create mipmaps
+    earthTexture = AcquireTexture("textures/earth720x360.jpg");
+    sunTexture = AcquireTexture("textures/sun1024x574.jpg");
+    asteroidTexture = AcquireTexture("textures/asteroid700x700.jpg");
+}
+
+// The belt
+int asteroidCount = 100000; // --asteroids
+bool useLod = true;         // --no-lod
+bool useImpostors = true;   // --no-impostors
+std::vector<AsteroidInstance> belt;
+FrameArena frameArena; // the level picked this frame, per asteroid
+StreamBuffer instanceStream;
+
+const float kSunRadius = 2.0f, kEarthRadius = 0.6f, kEarthOrbit = 5.0f;
+const float kBeltInner = 8.0f, kBeltOuter = 14.0f, kBeltThickness = 0.6f;
+
+void GenerateBelt()
+{
+    std::mt19937 gen(1234); // fixed, so runs are comparable
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    belt.resize(asteroidCount);
+    InitFrameArena(frameArena, (size_t)asteroidCount + kFrameArenaAlignment);
+    for (AsteroidInstance& a : belt)
+    {
+        float angle = unit(gen) * 6.2831853f;
+        float radius = kBeltInner + (kBeltOuter - kBeltInner) * unit(gen);
+        a.position[0] = radius * cosf(angle);
+        a.position[1] = (unit(gen) * 2.0f - 1.0f) * kBeltThickness;
+        a.position[2] = radius * sinf(angle);
+        a.scale = 0.01f + 0.07f * powf(unit(gen), 4.0f); // mostly small rocks
+        glm::vec3 axis = glm::normalize(glm::vec3(unit(gen) - 0.5f, unit(gen) - 0.5f, unit(gen) - 0.5f) + 1e-4f);
+        a.axis[0] = axis.x;
+        a.axis[1] = axis.y;
+        a.axis[2] = axis.z;
+        a.phase = unit(gen) * 6.2831853f;
+    }
+    // one frame of instances per stream region
+    InitStreamBuffer(instanceStream, (GLsizeiptr)asteroidCount * sizeof(AsteroidInstance));
+}
+
+// uniform locations, looked up once
+struct SphereUniforms
+{
+    int projection, view, model, time, surface, emissive, sunPosition;
+} sphereUniforms;
+
+struct ImpostorUniforms
+{
+    int projection, view, model, surface, cameraToWorld, sunPosition;
+} impostorUniforms;
+
+const float kFieldOfView = glm::radians(60.0f);
+glm::mat4 projection;
+
+void myInit()
+{
+    glClearColor(0.0, 0.0, 0.02, 0.0);
+    projection = glm::perspective(kFieldOfView, (float)Wwidth0 / Wheight0, 0.1f, 100.0f);
+
+    sphereUniforms.projection = glGetUniformLocation(sphereProgram, "projection");
+    sphereUniforms.view = glGetUniformLocation(sphereProgram, "view");
+    sphereUniforms.model = glGetUniformLocation(sphereProgram, "model");
+    sphereUniforms.time = glGetUniformLocation(sphereProgram, "time");
+    sphereUniforms.surface = glGetUniformLocation(sphereProgram, "surface");
+    sphereUniforms.emissive = glGetUniformLocation(sphereProgram, "emissive");
+    sphereUniforms.sunPosition = glGetUniformLocation(sphereProgram, "sunPosition");
+
+    impostorUniforms.projection = glGetUniformLocation(impostorProgram, "projection");
+    impostorUniforms.view = glGetUniformLocation(impostorProgram, "view");
+    impostorUniforms.model = glGetUniformLocation(impostorProgram, "model");
+    impostorUniforms.surface = glGetUniformLocation(impostorProgram, "surface");
+    impostorUniforms.cameraToWorld = glGetUniformLocation(impostorProgram, "cameraToWorld");
+    impostorUniforms.sunPosition = glGetUniformLocation(impostorProgram, "sunPosition");
+}
+
+// Statistics, printed once per second
+struct BeltStats
+{
+    unsigned long long trianglesSubmitted = 0; // with the current settings
+    unsigned long long trianglesWithoutLod = 0; // every asteroid at the high level
+    unsigned long long instances[kLodLevels] = {};
+    int frames = 0;
+    double lastPrint = 0.0;
+} stats;
+
+int TrianglesPerInstance(int level)
+{
+    return level == kImpostorLevel ? 2 : lods[level].indexCount / 3;
+}
+
+// Picks a level for every asteroid, then writes the instances grouped by level straight into
+// this frame's stream region. first[level] / count[level] locate each group.
+void BucketAsteroids(const glm::mat4& beltModel, const glm::vec3& cameraPos, GLintptr* first, int* count)
+{
+    glm::vec3 camera = glm::vec3(glm::inverse(beltModel) * glm::vec4(cameraPos, 1.0f));
+    float pixelsPerUnit = Wheight0 * 0.5f / tanf(kFieldOfView * 0.5f); // at distance 1
+    int lowest = useImpostors ? kImpostorLevel : kImpostorLevel - 1;
+
+    for (int level = 0; level < kLodLevels; level++)
+        count[level] = 0;
+    BeginArenaFrame(frameArena);
+    unsigned char* beltLevel = ArenaAllocArray<unsigned char>(frameArena, asteroidCount);
+    if (!beltLevel)
+        return;
+    for (int i = 0; i < asteroidCount; i++)
+    {
+        int level = 0;
+        if (useLod)
+        {
+            const AsteroidInstance& a = belt[i];
+            float dx = a.position[0] - camera.x, dy = a.position[1] - camera.y, dz = a.position[2] - camera.z;
+            float pixels = 2.0f * a.scale * pixelsPerUnit / sqrtf(dx * dx + dy * dy + dz * dz + 1e-6f);
+            while (level < lowest && pixels < kLodMinPixels[level])
+                level++;
+        }
+        beltLevel[i] = (unsigned char)level;
+        count[level]++;
+    }
+
+    int start[kLodLevels];
+    int total = 0;
+    for (int level = 0; level < kLodLevels; level++)
+    {
+        start[level] = total;
+        total += count[level];
+    }
+
+    GLintptr offset = 0;
+    AsteroidInstance* mapped = (AsteroidInstance*)StreamAlloc(instanceStream, (GLsizeiptr)total * sizeof(AsteroidInstance),
+                                                              sizeof(AsteroidInstance), &offset);
+    if (!mapped)
+    {
+        for (int level = 0; level < kLodLevels; level++)
+            count[level] = 0;
+        return;
+    }
+    int next[kLodLevels];
+    memcpy(next, start, sizeof(next));
+    for (int i = 0; i < asteroidCount; i++)
+        mapped[next[beltLevel[i]]++] = belt[i];
+    StreamUnmap(instanceStream);
+
+    for (int level = 0; level < kLodLevels; level++)
+        first[level] = offset + (GLintptr)start[level] * sizeof(AsteroidInstance);
+}
+
+// Scene entry points, used by main below and by scene_host.cpp
+void SceneInit(int width, int height)
+{
+    Wwidth0 = width;
+    Wheight0 = height;
+    InitMyShaders();
+    SetupVerticesData();
+    GenerateBelt();
+    myInit();
+    printf("Asteroids: %d instances, triangles per level:", asteroidCount);
+    for (int level = 0; level < kLodLevels; level++)
+        printf(" %s %d", kLodNames[level], TrianglesPerInstance(level));
+    printf("%s%s\n", useLod ? "" : " (LOD off)", useImpostors ? "" : " (impostors off)");
+}
+
+void SceneFrame(double time)
+{
+    // state other scenes in the same context may have changed
+    glEnable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+    glClearColor(0.0, 0.0, 0.02, 0.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    float t = (float)time;
+    glm::vec3 cameraPos(16.0f * cosf(t * 0.05f), 2.5f, 16.0f * sinf(t * 0.05f));
+    glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 beltModel = glm::rotate(glm::mat4(1.0f), t * 0.02f, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::vec3 sunPosition(0.0f);
+
+    glUseProgram(sphereProgram);
+    glUniformMatrix4fv(sphereUniforms.projection, 1, GL_FALSE, glm::value_ptr(projection));
+    glUniformMatrix4fv(sphereUniforms.view, 1, GL_FALSE, glm::value_ptr(view));
+    glUniform1f(sphereUniforms.time, t * 0.3f);
+    glUniform1i(sphereUniforms.surface, 0);
+    glUniform3fv(sphereUniforms.sunPosition, 1, glm::value_ptr(sunPosition));
+    glActiveTexture(GL_TEXTURE0);
+
+    // sun and earth: constant instance attributes
+    glBindVertexArray(planetVAO);
+    glVertexAttrib4f(4, 0.0f, 1.0f, 0.0f, 0.0f);
+    glm::mat4 identity(1.0f);
+    glUniformMatrix4fv(sphereUniforms.model, 1, GL_FALSE, glm::value_ptr(identity));
+    glUniform1i(sphereUniforms.emissive, 1);
+    glVertexAttrib4f(3, 0.0f, 0.0f, 0.0f, kSunRadius);
+    glBindTexture(GL_TEXTURE_2D, sunTexture);
+    glDrawElements(GL_TRIANGLES, lods[0].indexCount, GL_UNSIGNED_SHORT, 0);
+
+    glm::mat4 earthModel = glm::translate(identity, glm::vec3(kEarthOrbit * cosf(t * 0.2f), 0.0f, kEarthOrbit * sinf(t * 0.2f)));
+    glUniformMatrix4fv(sphereUniforms.model, 1, GL_FALSE, glm::value_ptr(earthModel));
+    glUniform1i(sphereUniforms.emissive, 0);
+    glVertexAttrib4f(3, 0.0f, 0.0f, 0.0f, kEarthRadius);
+    glBindTexture(GL_TEXTURE_2D, earthTexture);
+    glDrawElements(GL_TRIANGLES, lods[0].indexCount, GL_UNSIGNED_SHORT, 0);
+
+    HudCountDraws(2);
+
+    // the belt
+    BeginHudScope("belt");
+    BeginStreamFrame(instanceStream);
+    GLintptr first[kLodLevels];
+    int count[kLodLevels];
+    BucketAsteroids(beltModel, cameraPos, first, count);
+
+    glUniformMatrix4fv(sphereUniforms.model, 1, GL_FALSE, glm::value_ptr(beltModel));
+    glBindTexture(GL_TEXTURE_2D, asteroidTexture);
+    unsigned long long triangles = 0;
+    for (int level = 0; level < kImpostorLevel; level++)
+    {
+        if (count[level] == 0)
+            continue;
+        glBindVertexArray(lods[level].VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceStream.buffer);
+        InstanceLayout::Apply(first[level], 1);
+        glDrawElementsInstanced(GL_TRIANGLES, lods[level].indexCount, GL_UNSIGNED_SHORT, 0, count[level]);
+        triangles += (unsigned long long)count[level] * TrianglesPerInstance(level);
+        HudCountDraws(1);
+    }
+
+    if (count[kImpostorLevel] > 0)
+    {
+        glm::mat3 cameraToWorld = glm::transpose(glm::mat3(view));
+        glDisable(GL_CULL_FACE);
+        glUseProgram(impostorProgram);
+        glUniformMatrix4fv(impostorUniforms.projection, 1, GL_FALSE, glm::value_ptr(projection));
+        glUniformMatrix4fv(impostorUniforms.view, 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(impostorUniforms.model, 1, GL_FALSE, glm::value_ptr(beltModel));
+        glUniformMatrix3fv(impostorUniforms.cameraToWorld, 1, GL_FALSE, glm::value_ptr(cameraToWorld));
+        glUniform3fv(impostorUniforms.sunPosition, 1, glm::value_ptr(sunPosition));
+        glUniform1i(impostorUniforms.surface, 0);
+        glBindVertexArray(lods[kImpostorLevel].VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceStream.buffer);
+        InstanceLayout::Apply(first[kImpostorLevel], 1);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, lods[kImpostorLevel].indexCount, count[kImpostorLevel]);
+        triangles += (unsigned long long)count[kImpostorLevel] * TrianglesPerInstance(kImpostorLevel);
+        HudCountDraws(1);
+        glEnable(GL_CULL_FACE);
+    }
+    EndStreamFrame(instanceStream);
+    EndHudScope();
+    glBindVertexArray(0);
+    glDisable(GL_CULL_FACE);
+
+    stats.trianglesSubmitted += triangles;
+    stats.trianglesWithoutLod += (unsigned long long)asteroidCount * TrianglesPerInstance(0);
+    for (int level = 0; level < kLodLevels; level++)
+        stats.instances[level] += count[level];
+    stats.frames++;
+    if (time - stats.lastPrint >= 1.0)
+    {
+        printf("asteroids: %.1f fps |", stats.frames / (time - stats.lastPrint));
+        for (int level = 0; level < kLodLevels; level++)
+            printf(" %s %llu", kLodNames[level], stats.instances[level] / stats.frames);
+        printf(" | %.2fM triangles/frame (all high: %.2fM)\n", stats.trianglesSubmitted / 1e6 / stats.frames,
+               stats.trianglesWithoutLod / 1e6 / stats.frames);
+        stats = BeltStats();
+        stats.lastPrint = time;
+    }
+}
+
+void SceneShutdown()
+{
+    PrintStreamStats(instanceStream, "asteroid instances");
+    PrintFrameArenaStats(frameArena, "asteroid");
+    DestroyStreamBuffer(instanceStream);
+    for (int level = 0; level < kLodLevels; level++)
+    {
+        DeleteGLObjects(GL_VERTEX_ARRAY, 1, &lods[level].VAO);
+        ReleaseBuffer(lods[level].VBO);
+        if (lods[level].EBO)
+            ReleaseBuffer(lods[level].EBO);
+    }
+    DeleteGLObjects(GL_VERTEX_ARRAY, 1, &planetVAO);
+    ReleaseBuffer(lods[0].VBO); // the planet's references to the same buffers
+    ReleaseBuffer(lods[0].EBO);
+    ReleaseTexture(earthTexture);
+    ReleaseTexture(sunTexture);
+    ReleaseTexture(asteroidTexture);
+    ReleaseProgram(sphereProgram);
+    ReleaseProgram(impostorProgram);
+}
+
+} // namespace asteroids
+
+#ifndef SCENE_HOST
+int main(int argc, char** argv)
+{
+    using namespace asteroids;
+    const char* capturePath = NULL;
+    double dynresTarget = 0.0; // ms, 0 = off
+    const char* dynresLog = NULL;
+    bool hud = false;
+    bool checkHeap = false; // --heap-check: steady-state frames must not allocate
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--asteroids") == 0 && i + 1 < argc)
+            asteroidCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--no-lod") == 0)
+            useLod = false;
+        else if (strcmp(argv[i], "--no-impostors") == 0)
+            useImpostors = false;
+        else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+            capturePath = argv[++i];
+        else if (strcmp(argv[i], "--hud") == 0)
+            hud = true;
+        else if (strcmp(argv[i], "--heap-check") == 0)
+            checkHeap = true;
+        else if (strcmp(argv[i], "--dynres") == 0 && i + 1 < argc)
+        {
+            dynresTarget = atof(argv[++i]);
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                dynresLog = argv[++i];
+        }
+    }
+    if (asteroidCount < 1)
+        asteroidCount = 1;
+
+    // start GL context and O/S window using the GLFW helper library
+    if (!glfwInit())
+    {
+        fprintf(stderr, "ERROR: could not start GLFW3\n");
+        return 1;
+    }
+
+    GLFWwindow* window = glfwCreateWindow(Wwidth0, Wheight0, "Asteroid belt", NULL, NULL);
+    if (!window)
+    {
+        fprintf(stderr, "ERROR: could not open window with GLFW3\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glewInit();
+
+    SceneInit(Wwidth0, Wheight0);
+    FrameCapture capture;
+    if (capturePath && !InitFrameCapture(capture, capturePath, Wwidth0, Wheight0))
+        return 1;
+    DynamicResolution dynres;
+    if (dynresTarget > 0.0 && !InitDynamicResolution(dynres, Wwidth0, Wheight0, dynresTarget, dynresLog))
+        return 1;
+    if (hud && !InitPerfHud(Wwidth0, Wheight0))
+        return 1;
+    PrintGLTotals("after init");
+
+    if (checkHeap)
+        BeginHeapCheck();
+    /* Loop until the user closes the window */
+    while (!glfwWindowShouldClose(window))
+    {
+        /* Render here */
+        BeginHudFrame();
+        if (dynres.enabled)
+            BeginDynamicResolution(dynres);
+        BeginHudScope("scene");
+        SceneFrame(glfwGetTime());
+        EndHudScope();
+        if (dynres.enabled)
+            EndDynamicResolution(dynres);
+        DrawHud();
+        CaptureFrame(capture);
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+        CountFrameHeap();
+    }
+    FinishFrameCapture(capture);
+    DestroyDynamicResolution(dynres);
+    DestroyPerfHud();
+    SceneShutdown();
+    ReportGLLeaks();
+    // close GL context and any other GLFW resources
+    glfwTerminate();
+    return EndHeapCheck() ? 0 : 1;
+}
+#endif
@@ -0,0 +1,190 @@
+//Cuts an image into the tiled mip pyramid (.vtex) read by VirtualTexture.h.
+//
+//  img2vtex input.jpg output.vtex [tile]    convert (tile = texels per side, default 128)
+//  img2vtex --synthetic N output.vtex [tile] write a procedural N x N image, tile by tile, so
+//                                           N can be far beyond what fits in memory
+//
+//Builds without GL: g++ -O2 -std=c++17 img2vtex.cpp -o img2vtex
+#include "VirtualTexture.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+const uint32_t kDefaultTileSize = 128;
+const uint32_t kTileBorder = 1; // enough for bilinear filtering
+
+struct ImageLevel
+{
+    uint32_t width, height;
+    std::vector<unsigned char> texels; // RGBA8
+};
+
+// 2x2 box filter down to level.width x level.height (an odd last row or column is dropped).
+static ImageLevel Downsample(const ImageLevel& src, uint32_t width, uint32_t height)
+{
+    ImageLevel dst = { width, height, std::vector<unsigned char>((size_t)width * height * 4) };
+    for (uint32_t y = 0; y < height; y++)
+        for (uint32_t x = 0; x < width; x++)
+        {
+            uint32_t x0 = std::min(x * 2, src.width - 1), x1 = std::min(x * 2 + 1, src.width - 1);
+            uint32_t y0 = std::min(y * 2, src.height - 1), y1 = std::min(y * 2 + 1, src.height - 1);
+            for (int c = 0; c < 4; c++)
+            {
+                unsigned sum = src.texels[((size_t)y0 * src.width + x0) * 4 + c] +
+                               src.texels[((size_t)y0 * src.width + x1) * 4 + c] +
+                               src.texels[((size_t)y1 * src.width + x0) * 4 + c] +
+                               src.texels[((size_t)y1 * src.width + x1) * 4 + c];
+                dst.texels[((size_t)y * width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    return dst;
+}
+
+// Smooth colour bands with a grid of lines every 64 texels and a checker every 4096, evaluated
+// at level-0 coordinates; footprint = level-0 texels per texel of the level being written.
+static void SyntheticTexel(double x, double y, double footprint, unsigned char* rgba)
+{
+    double sum[3] = {};
+    const double offsets[4][2] = { { -0.25, -0.25 }, { 0.25, -0.25 }, { -0.25, 0.25 }, { 0.25, 0.25 } };
+    for (const auto& o : offsets)
+    {
+        double sx = x + o[0] * footprint, sy = y + o[1] * footprint;
+        double checker = ((int)std::floor(sx / 4096.0) + (int)std::floor(sy / 4096.0)) & 1 ? 0.8 : 1.0;
+        bool line = std::fmod(sx, 64.0) < 2.0 || std::fmod(sy, 64.0) < 2.0;
+        double shade = checker * (line ? 0.3 : 1.0);
+        sum[0] += shade * (0.5 + 0.5 * std::sin(sx * 0.0011));
+        sum[1] += shade * (0.5 + 0.5 * std::sin(sy * 0.0017 + 1.0));
+        sum[2] += shade * (0.5 + 0.5 * std::sin((sx + sy) * 0.0007 + 2.0));
+    }
+    for (int c = 0; c < 3; c++)
+        rgba[c] = (unsigned char)(sum[c] / 4.0 * 255.0 + 0.5);
+    rgba[3] = 255;
+}
+
+// Writes the header and every tile; texel(level, x, y, rgba) is called with x and y already
+// clamped to the level, so the borders of edge tiles repeat the edge.
+template <typename TexelFunction>
+static bool WriteVirtualTexture(const char* path, uint32_t width, uint32_t height, uint32_t tileSize,
+                                TexelFunction texel)
+{
+    VirtualTextureHeader h = {};
+    memcpy(h.magic, kVirtualTextureMagic, 4);
+    h.version = kVirtualTextureVersion;
+    h.width = width;
+    h.height = height;
+    h.tileSize = tileSize;
+    h.border = kTileBorder;
+    SetupVirtualTextureLevels(h);
+    h.tileOffset = (sizeof(h) + kVirtualTextureAlignment - 1) / kVirtualTextureAlignment * kVirtualTextureAlignment;
+    if (h.levels[h.levelCount - 1].pagesX != 1 || h.levels[h.levelCount - 1].pagesY != 1)
+    {
+        fprintf(stderr, "ERROR: %ux%u needs more than %d levels of %u texel tiles\n", width, height,
+                kVirtualTextureMaxLevels, tileSize);
+        return false;
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "ERROR: could not write %s\n", path);
+        return false;
+    }
+    fwrite(&h, 1, sizeof(h), file);
+    std::vector<char> zeros((size_t)(h.tileOffset - sizeof(h)));
+    fwrite(zeros.data(), 1, zeros.size(), file);
+
+    int padded = (int)VirtualTilePadded(h);
+    std::vector<unsigned char> tile((size_t)VirtualTileBytes(h));
+    for (uint32_t level = 0; level < h.levelCount; level++)
+    {
+        const VirtualTextureLevel& l = h.levels[level];
+        for (uint32_t py = 0; py < l.pagesY; py++)
+            for (uint32_t px = 0; px < l.pagesX; px++)
+            {
+                for (int ty = 0; ty < padded; ty++)
+                    for (int tx = 0; tx < padded; tx++)
+                    {
+                        long x = (long)(px * tileSize) + tx - (long)h.border;
+                        long y = (long)(py * tileSize) + ty - (long)h.border;
+                        x = std::min(std::max(x, 0L), (long)l.width - 1);
+                        y = std::min(std::max(y, 0L), (long)l.height - 1);
+                        texel(level, (uint32_t)x, (uint32_t)y, &tile[((size_t)ty * padded + tx) * 4]);
+                    }
+                fwrite(tile.data(), 1, tile.size(), file);
+            }
+        printf("level %u: %ux%u, %ux%u tiles\n", level, l.width, l.height, l.pagesX, l.pagesY);
+    }
+    bool ok = !ferror(file);
+    fclose(file);
+    if (!ok)
+    {
+        fprintf(stderr, "ERROR: could not write %s\n", path);
+        return false;
+    }
+    printf("%s: %ux%u, %u levels, %u tiles of %u texels, %.1f MB\n", path, width, height, h.levelCount, h.tileCount,
+           tileSize, (h.tileOffset + h.tileCount * VirtualTileBytes(h)) / 1048576.0);
+    return true;
+}
+
+static bool ConvertImage(const char* input, const char* output, uint32_t tileSize)
+{
+    int width, height, channels;
+    unsigned char* data = stbi_load(input, &width, &height, &channels, 4);
+    if (!data)
+    {
+        fprintf(stderr, "ERROR: could not load %s\n", input);
+        return false;
+    }
+    std::vector<ImageLevel> levels(1);
+    levels[0] = { (uint32_t)width, (uint32_t)height,
+                  std::vector<unsigned char>(data, data + (size_t)width * height * 4) };
+    stbi_image_free(data);
+
+    return WriteVirtualTexture(output, (uint32_t)width, (uint32_t)height, tileSize,
+                               [&](uint32_t level, uint32_t x, uint32_t y, unsigned char* rgba)
+                               {
+                                   while (levels.size() <= level)
+                                   {
+                                       const ImageLevel& last = levels.back();
+                                       uint32_t w = std::max(last.width / 2, 1u), h = std::max(last.height / 2, 1u);
+                                       levels.push_back(Downsample(last, w, h));
+                                   }
+                                   const ImageLevel& l = levels[level];
+                                   memcpy(rgba, &l.texels[((size_t)y * l.width + x) * 4], 4);
+                               });
+}
+
+static bool WriteSynthetic(const char* output, uint32_t size, uint32_t tileSize)
+{
+    return WriteVirtualTexture(output, size, size, tileSize,
+                               [](uint32_t level, uint32_t x, uint32_t y, unsigned char* rgba)
+                               {
+                                   double footprint = (double)(1u << level);
+                                   SyntheticTexel((x + 0.5) * footprint, (y + 0.5) * footprint, footprint, rgba);
+                               });
+}
+
+int main(int argc, char** argv)
+{
+    if ((argc == 4 || argc == 5) && strcmp(argv[1], "--synthetic") == 0)
+    {
+        int size = atoi(argv[2]);
+        uint32_t tileSize = argc == 5 ? (uint32_t)atoi(argv[4]) : kDefaultTileSize;
+        if (size > 0 && tileSize > 0 && tileSize <= 1024)
+            return WriteSynthetic(argv[3], (uint32_t)size, tileSize) ? 0 : 1;
+    }
+    else if (argc == 3 || argc == 4)
+    {
+        uint32_t tileSize = argc == 4 ? (uint32_t)atoi(argv[3]) : kDefaultTileSize;
+        if (tileSize > 0 && tileSize <= 1024)
+            return ConvertImage(argv[1], argv[2], tileSize) ? 0 : 1;
+    }
+    fprintf(stderr, "usage: img2vtex input.jpg output.vtex [tile]\n"
+                    "       img2vtex --synthetic N output.vtex [tile]\n");
+    return 1;
+}
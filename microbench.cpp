@@ -0,0 +1,446 @@
+//CPU microbenchmarks of the demos' hot kernels; needs no window and no GL context.
+//
+//  microbench [--filter text] [--samples N] [--save baseline.json] [--compare baseline.json] [--threshold percent]
+//
+//  --filter     run only the benchmarks whose name contains text
+//  --samples    timed samples per benchmark (default 15), each at least 10 ms long
+//  --save       write the results as a JSON baseline
+//  --compare    compare against a saved baseline; a benchmark whose median is slower by more than
+//               the threshold (default 10%) and by more than twice the noise is a regression, and
+//               the exit code is 1
+//
+//Run from the repository root: the image benchmarks decode every file in textures/.
+//Builds without GL libraries (GLEW and glm headers only): g++ -O2 -std=c++17 microbench.cpp -o microbench
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/type_ptr.hpp"
+#include "ProceduralMesh.h"
+#include "DemoKernels.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+const double kMinSampleMs = 10.0;
+const double kDefaultThreshold = 10.0; // percent
+
+volatile float sink; // results go here so the compiler cannot drop the work
+
+struct Benchmark
+{
+    std::string name;
+    double itemsPerOp; // throughput is reported in items per second
+    const char* unit;
+    std::function<void(size_t)> run; // runs the kernel this many times
+};
+
+struct Result
+{
+    std::string name;
+    double medianNs = 0.0, meanNs = 0.0, stddevNs = 0.0, minNs = 0.0; // per op
+    int samples = 0;
+    double itemsPerOp = 0.0;
+    std::string unit;
+};
+
+static double Seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Doubles the iteration count until one sample takes kMinSampleMs (this also warms the caches),
+// then times `samples` samples of that many iterations.
+static Result Measure(const Benchmark& benchmark, int samples)
+{
+    size_t iterations = 1;
+    for (;;)
+    {
+        auto start = std::chrono::steady_clock::now();
+        benchmark.run(iterations);
+        if (Seconds(start) * 1000.0 >= kMinSampleMs)
+            break;
+        iterations *= 2;
+    }
+
+    std::vector<double> ns(samples);
+    for (int i = 0; i < samples; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        benchmark.run(iterations);
+        ns[i] = Seconds(start) * 1e9 / iterations;
+    }
+
+    Result r;
+    r.name = benchmark.name;
+    r.samples = samples;
+    r.itemsPerOp = benchmark.itemsPerOp;
+    r.unit = benchmark.unit;
+    for (double t : ns)
+        r.meanNs += t;
+    r.meanNs /= samples;
+    for (double t : ns)
+        r.stddevNs += (t - r.meanNs) * (t - r.meanNs);
+    r.stddevNs = samples > 1 ? std::sqrt(r.stddevNs / (samples - 1)) : 0.0;
+    std::sort(ns.begin(), ns.end());
+    r.medianNs = samples % 2 ? ns[samples / 2] : 0.5 * (ns[samples / 2 - 1] + ns[samples / 2]);
+    r.minNs = ns[0];
+    return r;
+}
+
+static void PrintResult(const Result& r)
+{
+    double itemsPerSecond = r.medianNs > 0.0 ? r.itemsPerOp * 1e9 / r.medianNs : 0.0;
+    printf("%-36s %12.1f %6.1f%% %12.1f %10.2f M%s/s\n", r.name.c_str(), r.medianNs,
+           r.meanNs > 0.0 ? 100.0 * r.stddevNs / r.meanNs : 0.0, r.minNs, itemsPerSecond / 1e6, r.unit.c_str());
+}
+
+//--------------------------------------------------------------------------- kernels
+
+template <int Segments>
+static Benchmark CircleBenchmark()
+{
+    return { "circle/" + std::to_string(Segments), (double)Segments, "vertices",
+             [](size_t iterations)
+             {
+                 // a runtime radius, so MakeCircle is not folded at compile time as for kCircle*
+                 volatile float radius = 1.0f;
+                 float sum = 0.0f;
+                 for (size_t i = 0; i < iterations; i++)
+                 {
+                     std::array<PositionVertex, Segments> circle = MakeCircle<Segments>(radius);
+                     sum += circle[i % Segments].position[1];
+                 }
+                 sink = sum;
+             } };
+}
+
+// Snow's rectangle, with flakes spread over its height so some respawn in every sample.
+static Benchmark FlakeBenchmark()
+{
+    const float rectangleX = 0.0f, halfWidth = 7.0f, halfHeight = 3.0f;
+    auto flakes = std::make_shared<std::vector<Flake>>(1024);
+    auto gen = std::make_shared<std::mt19937>(1u);
+    std::uniform_real_distribution<float> x(-halfWidth, halfWidth), y(-halfHeight, halfHeight), radius(0.02f, 0.2f);
+    for (Flake& flake : *flakes)
+        flake = { x(*gen), y(*gen), radius(*gen) };
+    return { "flake/step", 1.0, "flakes",
+             [=](size_t iterations)
+             {
+                 std::vector<Flake>& f = *flakes;
+                 for (size_t i = 0; i < iterations; i++)
+                     StepFlake(f[i & 1023], rectangleX, halfWidth, halfHeight, *gen);
+                 sink = f[0].y;
+             } };
+}
+
+// square's cursor callback on an 800 x 800 window: cursor to clip space, then the hit test.
+static Benchmark HitBenchmark()
+{
+    const int width = 800, height = 800;
+    const float xmax = 10.0f, half = 1.0f;
+    auto cursors = std::make_shared<std::vector<double>>(2 * 4096);
+    std::mt19937 gen(2u);
+    std::uniform_real_distribution<double> pixel(0.0, width);
+    for (double& c : *cursors)
+        c = pixel(gen);
+    return { "square/hit", 1.0, "tests",
+             [=](size_t iterations)
+             {
+                 const double* c = cursors->data();
+                 int hits = 0;
+                 for (size_t i = 0; i < iterations; i++)
+                 {
+                     size_t k = (i & 4095) * 2;
+                     float clipX, clipY;
+                     CursorToClip(c[k], c[k + 1], width, height, clipX, clipY);
+                     hits += SquareHit(clipX, clipY, 2.5f, -1.5f, half, xmax);
+                 }
+                 sink = (float)hits;
+             } };
+}
+
+static Benchmark QuadMatrixBenchmark()
+{
+    return { "matrix/quad", 1.0, "matrices",
+             [](size_t iterations)
+             {
+                 float sum = 0.0f;
+                 for (size_t i = 0; i < iterations; i++)
+                 {
+                     glm::mat4 model = QuadModelMatrix((float)(i & 1023) * 0.35f);
+                     sum += glm::value_ptr(model)[5];
+                 }
+                 sink = sum;
+             } };
+}
+
+// opencube's 10 x 10 grid.
+static Benchmark CubeMatrixBenchmark()
+{
+    return { "matrix/cube", 1.0, "matrices",
+             [](size_t iterations)
+             {
+                 const int grid = 10;
+                 const float spacing = 20.0f / grid;
+                 float sum = 0.0f;
+                 for (size_t i = 0; i < iterations; i++)
+                 {
+                     int cube = (int)(i % (grid * grid));
+                     glm::vec3 position(-10.0f + spacing * (cube % grid + 0.5f), -10.0f + spacing * (cube / grid + 0.5f), 0.0f);
+                     glm::mat4 model = CubeModelMatrix(position, 1.0f / grid, (float)(i & 1023) * 0.35f);
+                     sum += glm::value_ptr(model)[12];
+                 }
+                 sink = sum;
+             } };
+}
+
+// RGB8 to RGBA8 with opaque alpha, what a loader does to upload RGB images as RGBA.
+static void ExpandRGBToRGBA(const unsigned char* rgb, unsigned char* rgba, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; i++)
+    {
+        rgba[i * 4 + 0] = rgb[i * 3 + 0];
+        rgba[i * 4 + 1] = rgb[i * 3 + 1];
+        rgba[i * 4 + 2] = rgb[i * 3 + 2];
+        rgba[i * 4 + 3] = 255;
+    }
+}
+
+// Per image: the decode AcquireTexture does (native channels), the RGB to RGBA expansion of its
+// result, and stb_image decoding straight to RGBA for comparison. The file is read once up front.
+static void AddImageBenchmarks(std::vector<Benchmark>& benchmarks, const char* directory)
+{
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+        if (entry.is_regular_file())
+            paths.push_back(entry.path().string());
+    if (error)
+        fprintf(stderr, "ERROR: could not list %s, run from the repository root\n", directory);
+    std::sort(paths.begin(), paths.end());
+
+    for (const std::string& path : paths)
+    {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file)
+            continue;
+        auto bytes = std::make_shared<std::vector<unsigned char>>();
+        unsigned char buffer[65536];
+        for (size_t n; (n = fread(buffer, 1, sizeof(buffer), file)) > 0;)
+            bytes->insert(bytes->end(), buffer, buffer + n);
+        fclose(file);
+
+        int width, height, channels;
+        unsigned char* data = stbi_load_from_memory(bytes->data(), (int)bytes->size(), &width, &height, &channels, 0);
+        std::string name = std::filesystem::path(path).filename().string();
+        if (!data)
+        {
+            printf("skipping %s: stb_image cannot decode it\n", name.c_str());
+            continue;
+        }
+        double pixels = (double)width * height;
+
+        benchmarks.push_back({ "decode/" + name, pixels, "pixels",
+                               [=](size_t iterations)
+                               {
+                                   for (size_t i = 0; i < iterations; i++)
+                                   {
+                                       int w, h, c;
+                                       unsigned char* d = stbi_load_from_memory(bytes->data(), (int)bytes->size(), &w, &h, &c, 0);
+                                       sink = d ? d[0] : 0;
+                                       stbi_image_free(d);
+                                   }
+                               } });
+        if (channels == 3)
+        {
+            auto rgb = std::make_shared<std::vector<unsigned char>>(data, data + (size_t)width * height * 3);
+            auto rgba = std::make_shared<std::vector<unsigned char>>((size_t)width * height * 4);
+            benchmarks.push_back({ "expand/" + name, pixels, "pixels",
+                                   [=](size_t iterations)
+                                   {
+                                       for (size_t i = 0; i < iterations; i++)
+                                           ExpandRGBToRGBA(rgb->data(), rgba->data(), rgb->size() / 3);
+                                       sink = (*rgba)[rgba->size() / 2];
+                                   } });
+        }
+        benchmarks.push_back({ "decode_rgba/" + name, pixels, "pixels",
+                               [=](size_t iterations)
+                               {
+                                   for (size_t i = 0; i < iterations; i++)
+                                   {
+                                       int w, h, c;
+                                       unsigned char* d = stbi_load_from_memory(bytes->data(), (int)bytes->size(), &w, &h, &c, 4);
+                                       sink = d ? d[0] : 0;
+                                       stbi_image_free(d);
+                                   }
+                               } });
+        stbi_image_free(data);
+    }
+}
+
+//--------------------------------------------------------------------------- baselines
+
+// One benchmark per line, so LoadBaseline can read it back with sscanf.
+static bool SaveBaseline(const char* path, const std::vector<Result>& results)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        fprintf(stderr, "ERROR: could not write %s\n", path);
+        return false;
+    }
+    fprintf(file, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result& r = results[i];
+        fprintf(file,
+                "    { \"name\": \"%s\", \"ns_per_op\": %.3f, \"mean_ns\": %.3f, \"stddev_ns\": %.3f, \"min_ns\": %.3f, "
+                "\"samples\": %d, \"items_per_op\": %.0f, \"unit\": \"%s\" }%s\n",
+                r.name.c_str(), r.medianNs, r.meanNs, r.stddevNs, r.minNs, r.samples, r.itemsPerOp, r.unit.c_str(),
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    bool ok = !ferror(file);
+    fclose(file);
+    if (ok)
+        printf("saved %zu benchmarks to %s\n", results.size(), path);
+    else
+        fprintf(stderr, "ERROR: could not write %s\n", path);
+    return ok;
+}
+
+// Reads what SaveBaseline writes.
+static bool LoadBaseline(const char* path, std::vector<Result>& baseline)
+{
+    FILE* file = fopen(path, "r");
+    if (!file)
+    {
+        fprintf(stderr, "ERROR: could not open %s\n", path);
+        return false;
+    }
+    char line[1024], name[512], unit[64];
+    while (fgets(line, sizeof(line), file))
+    {
+        Result r;
+        if (sscanf(line,
+                   " { \"name\": \"%511[^\"]\", \"ns_per_op\": %lf, \"mean_ns\": %lf, \"stddev_ns\": %lf, \"min_ns\": %lf, "
+                   "\"samples\": %d, \"items_per_op\": %lf, \"unit\": \"%63[^\"]\"",
+                   name, &r.medianNs, &r.meanNs, &r.stddevNs, &r.minNs, &r.samples, &r.itemsPerOp, unit) == 8)
+        {
+            r.name = name;
+            r.unit = unit;
+            baseline.push_back(r);
+        }
+    }
+    fclose(file);
+    if (baseline.empty())
+    {
+        fprintf(stderr, "ERROR: %s holds no benchmarks\n", path);
+        return false;
+    }
+    return true;
+}
+
+// Returns the number of regressions.
+static int Compare(const std::vector<Result>& results, const std::vector<Result>& baseline, double threshold)
+{
+    int regressions = 0, improvements = 0;
+    printf("\n%-36s %12s %12s %8s\n", "benchmark", "base ns/op", "ns/op", "change");
+    for (const Result& r : results)
+    {
+        auto base = std::find_if(baseline.begin(), baseline.end(), [&](const Result& b) { return b.name == r.name; });
+        if (base == baseline.end())
+        {
+            printf("%-36s %12s %12.1f %8s\n", r.name.c_str(), "-", r.medianNs, "new");
+            continue;
+        }
+        double change = 100.0 * (r.medianNs - base->medianNs) / base->medianNs;
+        double noise = 2.0 * std::max(r.stddevNs, base->stddevNs);
+        const char* verdict = "";
+        if (change > threshold && r.medianNs - base->medianNs > noise)
+        {
+            verdict = "  REGRESSION";
+            regressions++;
+        }
+        else if (change < -threshold && base->medianNs - r.medianNs > noise)
+        {
+            verdict = "  faster";
+            improvements++;
+        }
+        printf("%-36s %12.1f %12.1f %+7.1f%%%s\n", r.name.c_str(), base->medianNs, r.medianNs, change, verdict);
+    }
+    printf("%d regressions, %d improvements beyond %.0f%% and the noise\n", regressions, improvements, threshold);
+    return regressions;
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = NULL;
+    const char* savePath = NULL;
+    const char* comparePath = NULL;
+    int samples = 15;
+    double threshold = kDefaultThreshold;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+            samples = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+            savePath = argv[++i];
+        else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc)
+            comparePath = argv[++i];
+        else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+            threshold = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: microbench [--filter text] [--samples N] [--save baseline.json] "
+                            "[--compare baseline.json] [--threshold percent]\n");
+            return 1;
+        }
+    }
+
+    std::vector<Result> baseline;
+    if (comparePath && !LoadBaseline(comparePath, baseline))
+        return 1;
+
+    std::vector<Benchmark> benchmarks;
+    benchmarks.push_back(CircleBenchmark<16>());
+    benchmarks.push_back(CircleBenchmark<32>());
+    benchmarks.push_back(CircleBenchmark<64>());
+    benchmarks.push_back(CircleBenchmark<100>());
+    benchmarks.push_back(CircleBenchmark<256>());
+    benchmarks.push_back(CircleBenchmark<1024>());
+    benchmarks.push_back(FlakeBenchmark());
+    benchmarks.push_back(HitBenchmark());
+    benchmarks.push_back(QuadMatrixBenchmark());
+    benchmarks.push_back(CubeMatrixBenchmark());
+    AddImageBenchmarks(benchmarks, "textures");
+
+    printf("%-36s %12s %7s %12s %16s\n", "benchmark", "ns/op", "+-", "min ns/op", "throughput");
+    std::vector<Result> results;
+    for (const Benchmark& benchmark : benchmarks)
+    {
+        if (filter && benchmark.name.find(filter) == std::string::npos)
+            continue;
+        results.push_back(Measure(benchmark, samples));
+        PrintResult(results.back());
+    }
+
+    if (savePath && !SaveBaseline(savePath, results))
+        return 1;
+    if (comparePath)
+        return Compare(results, baseline, threshold) ? 1 : 0;
+    return 0;
+}
@@ -0,0 +1,345 @@
+//Converts Wavefront OBJ files to the binary .mesh format read by MeshFile.h
+//and benchmarks loading both.
+//
+//  obj2mesh input.obj output.mesh        convert
+//  obj2mesh --grid N output.obj          write a synthetic N x N quad grid (2*N*N triangles)
+//  obj2mesh --bench input.obj input.mesh time OBJ parsing against mapping the .mesh
+//
+//Builds without GL: g++ -O2 -std=c++17 obj2mesh.cpp -o obj2mesh
+#include "MeshFile.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// GL enums stored in the header
+const uint32_t kGLFloat = 0x1406;
+const uint32_t kGLUnsignedShort = 0x1403;
+const uint32_t kGLUnsignedInt = 0x1405;
+
+struct ObjMesh
+{
+    std::vector<float> vertices; // interleaved: position, [uv], [normal]
+    std::vector<uint32_t> indices;
+    int floatsPerVertex = 3;
+    bool hasUV = false, hasNormal = false;
+};
+
+struct ObjKey
+{
+    int v, vt, vn;
+    bool operator==(const ObjKey& o) const { return v == o.v && vt == o.vt && vn == o.vn; }
+};
+
+struct ObjKeyHash
+{
+    size_t operator()(const ObjKey& k) const
+    {
+        return ((size_t)k.v * 73856093u) ^ ((size_t)k.vt * 19349663u) ^ ((size_t)k.vn * 83492791u);
+    }
+};
+
+// OBJ indices are 1-based, negative ones count from the end
+static int ObjIndex(int index, size_t count)
+{
+    return index < 0 ? (int)count + index : index - 1;
+}
+
+static bool ParseObj(const char* path, ObjMesh& mesh)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "ERROR: could not open %s\n", path);
+        return false;
+    }
+    std::vector<float> positions, uvs, normals;
+    std::vector<ObjKey> faceKeys;
+    std::vector<ObjKey> corners;
+    char line[1024];
+    while (fgets(line, sizeof(line), file))
+    {
+        char* p = line;
+        if (p[0] == 'v' && p[1] == ' ')
+        {
+            float x, y, z;
+            if (sscanf(p + 2, "%f %f %f", &x, &y, &z) == 3)
+                positions.insert(positions.end(), { x, y, z });
+        }
+        else if (p[0] == 'v' && p[1] == 't')
+        {
+            float u = 0, v = 0;
+            sscanf(p + 3, "%f %f", &u, &v);
+            uvs.insert(uvs.end(), { u, v });
+        }
+        else if (p[0] == 'v' && p[1] == 'n')
+        {
+            float x, y, z;
+            if (sscanf(p + 3, "%f %f %f", &x, &y, &z) == 3)
+                normals.insert(normals.end(), { x, y, z });
+        }
+        else if (p[0] == 'f' && p[1] == ' ')
+        {
+            corners.clear();
+            p += 2;
+            while (*p)
+            {
+                while (*p == ' ' || *p == '\t') p++;
+                if (*p == '\0' || *p == '\n' || *p == '\r') break;
+                ObjKey key = { 0, -1, -1 };
+                key.v = ObjIndex((int)strtol(p, &p, 10), positions.size() / 3);
+                if (*p == '/')
+                {
+                    p++;
+                    if (*p != '/')
+                        key.vt = ObjIndex((int)strtol(p, &p, 10), uvs.size() / 2);
+                    if (*p == '/')
+                    {
+                        p++;
+                        key.vn = ObjIndex((int)strtol(p, &p, 10), normals.size() / 3);
+                    }
+                }
+                while (*p && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') p++;
+                corners.push_back(key);
+            }
+            // triangulate as a fan
+            for (size_t i = 2; i < corners.size(); i++)
+                faceKeys.insert(faceKeys.end(), { corners[0], corners[i - 1], corners[i] });
+        }
+    }
+    fclose(file);
+
+    mesh.hasUV = !uvs.empty();
+    mesh.hasNormal = !normals.empty();
+    mesh.floatsPerVertex = 3 + (mesh.hasUV ? 2 : 0) + (mesh.hasNormal ? 3 : 0);
+
+    // one output vertex per unique (v, vt, vn)
+    std::unordered_map<ObjKey, uint32_t, ObjKeyHash> unique;
+    unique.reserve(faceKeys.size());
+    mesh.indices.reserve(faceKeys.size());
+    for (const ObjKey& key : faceKeys)
+    {
+        auto found = unique.find(key);
+        if (found != unique.end())
+        {
+            mesh.indices.push_back(found->second);
+            continue;
+        }
+        uint32_t index = (uint32_t)unique.size();
+        unique.emplace(key, index);
+        mesh.indices.push_back(index);
+        for (int c = 0; c < 3; c++)
+            mesh.vertices.push_back(key.v >= 0 && (size_t)key.v * 3 + c < positions.size() ? positions[key.v * 3 + c] : 0.0f);
+        if (mesh.hasUV)
+            for (int c = 0; c < 2; c++)
+                mesh.vertices.push_back(key.vt >= 0 && (size_t)key.vt * 2 + c < uvs.size() ? uvs[key.vt * 2 + c] : 0.0f);
+        if (mesh.hasNormal)
+            for (int c = 0; c < 3; c++)
+                mesh.vertices.push_back(key.vn >= 0 && (size_t)key.vn * 3 + c < normals.size() ? normals[key.vn * 3 + c] : 0.0f);
+    }
+    return true;
+}
+
+// Greedy meshlets over the index order: close a meshlet at 64 unique vertices or 124 triangles.
+static std::vector<MeshFileMeshlet> BuildMeshlets(const ObjMesh& mesh)
+{
+    std::vector<MeshFileMeshlet> meshlets;
+    std::vector<uint32_t> members;
+    std::unordered_map<uint32_t, int> seen;
+    size_t start = 0;
+    auto close = [&](size_t end)
+    {
+        if (end == start)
+            return;
+        MeshFileMeshlet m = {};
+        m.firstIndex = (uint32_t)start;
+        m.indexCount = (uint32_t)(end - start);
+        float lo[3] = { 1e30f, 1e30f, 1e30f }, hi[3] = { -1e30f, -1e30f, -1e30f };
+        for (uint32_t v : members)
+            for (int c = 0; c < 3; c++)
+            {
+                float p = mesh.vertices[(size_t)v * mesh.floatsPerVertex + c];
+                lo[c] = std::fmin(lo[c], p);
+                hi[c] = std::fmax(hi[c], p);
+            }
+        for (int c = 0; c < 3; c++)
+            m.center[c] = 0.5f * (lo[c] + hi[c]);
+        for (uint32_t v : members)
+        {
+            const float* p = &mesh.vertices[(size_t)v * mesh.floatsPerVertex];
+            float dx = p[0] - m.center[0], dy = p[1] - m.center[1], dz = p[2] - m.center[2];
+            m.radius = std::fmax(m.radius, std::sqrt(dx * dx + dy * dy + dz * dz));
+        }
+        meshlets.push_back(m);
+        members.clear();
+        seen.clear();
+        start = end;
+    };
+    for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3)
+    {
+        int added = 0;
+        for (int c = 0; c < 3; c++)
+            added += seen.count(mesh.indices[t + c]) ? 0 : 1;
+        if (members.size() + added > 64 || (t - start) / 3 >= 124)
+            close(t);
+        for (int c = 0; c < 3; c++)
+            if (seen.emplace(mesh.indices[t + c], 1).second)
+                members.push_back(mesh.indices[t + c]);
+    }
+    close(mesh.indices.size());
+    return meshlets;
+}
+
+static bool WriteMeshFile(const char* path, const ObjMesh& mesh)
+{
+    std::vector<MeshFileMeshlet> meshlets = BuildMeshlets(mesh);
+    uint32_t vertexCount = (uint32_t)(mesh.vertices.size() / mesh.floatsPerVertex);
+    bool shortIndices = vertexCount <= 65536;
+
+    MeshFileHeader h = {};
+    memcpy(h.magic, kMeshFileMagic, 4);
+    h.version = kMeshFileVersion;
+    h.vertexCount = vertexCount;
+    h.vertexStride = mesh.floatsPerVertex * sizeof(float);
+    h.indexCount = (uint32_t)mesh.indices.size();
+    h.indexType = shortIndices ? kGLUnsignedShort : kGLUnsignedInt;
+    uint32_t offset = 0;
+    h.attribs[h.attribCount++] = { 0, 3, kGLFloat, 0, offset }; // same locations as the demos
+    offset += 12;
+    if (mesh.hasUV)
+    {
+        h.attribs[h.attribCount++] = { 1, 2, kGLFloat, 0, offset };
+        offset += 8;
+    }
+    if (mesh.hasNormal)
+        h.attribs[h.attribCount++] = { 3, 3, kGLFloat, 0, offset };
+    for (int c = 0; c < 3; c++)
+    {
+        h.boundsMin[c] = vertexCount ? 1e30f : 0.0f;
+        h.boundsMax[c] = vertexCount ? -1e30f : 0.0f;
+    }
+    for (uint32_t v = 0; v < vertexCount; v++)
+        for (int c = 0; c < 3; c++)
+        {
+            float p = mesh.vertices[(size_t)v * mesh.floatsPerVertex + c];
+            h.boundsMin[c] = std::fmin(h.boundsMin[c], p);
+            h.boundsMax[c] = std::fmax(h.boundsMax[c], p);
+        }
+
+    h.vertexSize = (uint64_t)vertexCount * h.vertexStride;
+    h.vertexOffset = AlignMeshOffset(sizeof(MeshFileHeader));
+    h.indexSize = (uint64_t)h.indexCount * (shortIndices ? 2 : 4);
+    h.indexOffset = AlignMeshOffset(h.vertexOffset + h.vertexSize);
+    h.meshletCount = (uint32_t)meshlets.size();
+    h.meshletOffset = AlignMeshOffset(h.indexOffset + h.indexSize);
+
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "ERROR: could not write %s\n", path);
+        return false;
+    }
+    auto writeAt = [&](uint64_t at, const void* data, size_t size)
+    {
+        static const char zeros[kMeshFileAlignment] = {};
+        long pos = ftell(file);
+        if ((uint64_t)pos < at)
+            fwrite(zeros, 1, (size_t)(at - pos), file);
+        fwrite(data, 1, size, file);
+    };
+    writeAt(0, &h, sizeof(h));
+    writeAt(h.vertexOffset, mesh.vertices.data(), (size_t)h.vertexSize);
+    if (shortIndices)
+    {
+        std::vector<uint16_t> shorts(mesh.indices.begin(), mesh.indices.end());
+        writeAt(h.indexOffset, shorts.data(), (size_t)h.indexSize);
+    }
+    else
+        writeAt(h.indexOffset, mesh.indices.data(), (size_t)h.indexSize);
+    writeAt(h.meshletOffset, meshlets.data(), meshlets.size() * sizeof(MeshFileMeshlet));
+    fclose(file);
+
+    printf("%s: %u vertices, %u triangles, %u meshlets, %u bytes/vertex\n", path, h.vertexCount,
+           h.indexCount / 3, h.meshletCount, h.vertexStride);
+    return true;
+}
+
+static bool WriteGridObj(const char* path, int n)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "ERROR: could not write %s\n", path);
+        return false;
+    }
+    for (int y = 0; y <= n; y++)
+        for (int x = 0; x <= n; x++)
+            fprintf(file, "v %f %f %f\nvt %f %f\n", x / (float)n - 0.5f, y / (float)n - 0.5f,
+                    0.05f * sinf(x * 0.1f) * cosf(y * 0.1f), x / (float)n, y / (float)n);
+    for (int y = 0; y < n; y++)
+        for (int x = 0; x < n; x++)
+        {
+            int a = y * (n + 1) + x + 1, b = a + 1, c = a + n + 1, d = c + 1;
+            fprintf(file, "f %d/%d %d/%d %d/%d %d/%d\n", a, a, b, b, d, d, c, c);
+        }
+    fclose(file);
+    printf("%s: %d triangles\n", path, 2 * n * n);
+    return true;
+}
+
+static double Milliseconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Both paths end with the vertex and index bytes readable in memory, which is what
+// glBufferData needs; the mapped file is touched page by page so the page faults count.
+static int Bench(const char* objPath, const char* meshPath)
+{
+    const int runs = 5;
+    double objBest = 1e30, meshBest = 1e30;
+    size_t triangles = 0;
+    for (int run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        ObjMesh obj;
+        if (!ParseObj(objPath, obj))
+            return 1;
+        objBest = std::fmin(objBest, Milliseconds(start));
+        triangles = obj.indices.size() / 3;
+
+        start = std::chrono::steady_clock::now();
+        MeshFile mesh;
+        if (!OpenMeshFile(meshPath, mesh))
+            return 1;
+        volatile unsigned char sink = 0;
+        const unsigned char* bytes = (const unsigned char*)mesh.base;
+        for (size_t i = 0; i < mesh.size; i += 4096)
+            sink = sink + bytes[i];
+        meshBest = std::fmin(meshBest, Milliseconds(start));
+        CloseMeshFile(mesh);
+    }
+    printf("%zu triangles, best of %d: OBJ parse %.2f ms, mesh map %.2f ms (%.1fx faster)\n", triangles, runs,
+           objBest, meshBest, meshBest > 0.0 ? objBest / meshBest : 0.0);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 4 && strcmp(argv[1], "--grid") == 0)
+        return WriteGridObj(argv[3], atoi(argv[2])) ? 0 : 1;
+    if (argc == 4 && strcmp(argv[1], "--bench") == 0)
+        return Bench(argv[2], argv[3]);
+    if (argc == 3)
+    {
+        ObjMesh mesh;
+        return ParseObj(argv[1], mesh) && WriteMeshFile(argv[2], mesh) ? 0 : 1;
+    }
+    fprintf(stderr, "usage: obj2mesh input.obj output.mesh\n"
+                    "       obj2mesh --grid N output.obj\n"
+                    "       obj2mesh --bench input.obj input.mesh\n");
+    return 1;
+}
@@ -1,14 +1,35 @@
+#ifndef SCENE_HOST // the host counts heap allocations itself
+#define FRAME_ARENA_HEAP_COUNTER // --heap-check
+#endif
 #include "GL/glew.h" // include GLEW and new version of GL on Windows
 #include "GL/glfw3.h" // GLFW helper library
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
-
+#include "ResourceManager.h"
+#include "CommandList.h"
+#include "VertexQuantize.h"
+#include "OverdrawView.h"
+#include "FrameCapture.h"
+#include "DynamicResolution.h"
+#include "PerfHud.h"
+#include "WorkerPool.h"
+#include "MeshFile.h"
+#include "DemoKernels.h"
+
+#ifndef SCENE_HOST // the host compiles stb_image itself
 #define STB_IMAGE_IMPLEMENTATION
+#endif
 #include "stb_image.h" // for texture loading
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <vector>
+
+namespace cube {
 
 // window size
 unsigned int Wwidth0 = 800, Wheight0 = 800;
@@ -50,29 +71,13 @@ const char* fragmentShaderSource = "#version 330 core\n"
 
 unsigned int shaderProgram;
 unsigned int texture1, texture2;
+int modelLocation, useTextureLocation;
 
 // Function to initialize shaders
 void InitMyShaders()
 {
-    // vertex shader
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-    
-    // fragment shader
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-    
-    // link shaders
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    
-    // delete shaders
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    // compile + link, or load the program binary cached by a previous run
+    shaderProgram = AcquireProgram("opencube", vertexShaderSource, fragmentShaderSource);
 }
 
 float xmin = -2.0f, xmax = 2.0f, ymin = -2.0f, ymax = 2.0f, zmin = -2.0f, zmax = 2.0f;
@@ -150,115 +155,77 @@ float colors_right[] = {
     1.0f, 1.0f, 0.0f  // yellow
 };
 
-unsigned int VAOs[4], VBOs[4], VBOCs[4];
+unsigned int VAOs[4], VBOs[4];
+int cubeGrid = 1; // cubeGrid x cubeGrid cubes, --cubes N
+
+// --mesh file.mesh: every cube is replaced by the mesh (written by obj2mesh), fitted into it
+const char* meshPath = NULL;
+unsigned int meshVAO = 0, meshVBO = 0, meshEBO = 0;
+int meshIndexCount = 0;
+GLenum meshIndexType = 0;
+bool meshTextured = false; // has uvs at location 1, else drawn in meshColor
+glm::mat4 meshFit(1.0f);   // bounds to the unit cube centred on the origin
+const float meshColor[3] = { 0.8f, 0.8f, 0.8f };
+
+// Maps the file, uploads it straight from the mapping and unmaps it again.
+bool SetupMesh(const char* path)
+{
+    MeshFile mesh;
+    if (!OpenMeshFile(path, mesh))
+        return false;
+    const MeshFileHeader* h = mesh.header;
+    UploadMeshFile(mesh, &meshVAO, &meshVBO, &meshEBO);
+    meshIndexCount = (int)h->indexCount;
+    meshIndexType = h->indexType;
+    meshTextured = false;
+    for (uint32_t i = 0; i < h->attribCount; i++)
+        meshTextured = meshTextured || h->attribs[i].location == 1;
+    glm::vec3 boundsMin(h->boundsMin[0], h->boundsMin[1], h->boundsMin[2]);
+    glm::vec3 boundsMax(h->boundsMax[0], h->boundsMax[1], h->boundsMax[2]);
+    glm::vec3 size = boundsMax - boundsMin;
+    float extent = std::max(size.x, std::max(size.y, size.z));
+    meshFit = glm::scale(glm::mat4(1.0f), glm::vec3(extent > 0.0f ? 1.0f / extent : 1.0f));
+    meshFit = glm::translate(meshFit, (boundsMin + boundsMax) * -0.5f);
+    printf("mesh %s: %u vertices, %u triangles, %u bytes/vertex\n", path, h->vertexCount, h->indexCount / 3,
+           h->vertexStride);
+    CloseMeshFile(mesh);
+    return true;
+}
+
+// Each face is packed into one interleaved stream: half-float position, unorm16 uv, RGBA8 color
+// (16 bytes instead of 5 + 3 floats in two buffers).
+void SetupFace(int face, const float* vertices, const float* colors)
+{
+    QuantizedMesh mesh = QuantizeVertices(6, POSITION_HALF, vertices, 5, vertices + 3, 5, colors, 3);
+    if (face == 0)
+        PrintQuantizeReport("cube face", mesh, 8);
+
+    glBindVertexArray(VAOs[face]);
+    GL_TRACK(GL_VERTEX_ARRAY, VAOs[face], "cube face", 0);
+    VBOs[face] = AcquireBuffer(mesh.data.data(), mesh.data.size(), "cube face");
+    glBindBuffer(GL_ARRAY_BUFFER, VBOs[face]);
+    ApplyQuantizedLayout(mesh);
+}
 
 void SetupVerticesData()
 {
+    if (meshPath)
+        SetupMesh(meshPath);
     glGenVertexArrays(4, VAOs);
-    glGenBuffers(4, VBOs);
-    glGenBuffers(4, VBOCs);
-
-    // Setup for front face
-    glBindVertexArray(VAOs[0]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices_front), vertices_front, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOCs[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(colors_front), colors_front, GL_STATIC_DRAW);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(2);
-
-    // Setup for back face
-    glBindVertexArray(VAOs[1]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[1]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices_back), vertices_back, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOCs[1]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(colors_back), colors_back, GL_STATIC_DRAW);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(2);
-
-    // Setup for left face
-    glBindVertexArray(VAOs[2]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[2]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices_left), vertices_left, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOCs[2]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(colors_left), colors_left, GL_STATIC_DRAW);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(2);
-
-    // Setup for right face
-    glBindVertexArray(VAOs[3]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[3]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices_right), vertices_right, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOCs[3]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(colors_right), colors_right, GL_STATIC_DRAW);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(2);
-
-    // Load and create textures 
-    glGenTextures(1, &texture1);
-    glBindTexture(GL_TEXTURE_2D, texture1);
-
-    // Set the texture wrapping parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-    // Set texture filtering parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    // Load image, create texture and generate mipmaps
-    int width, height, nrChannels;
-    unsigned char *data = stbi_load("textures/pollock.jpg", &width, &height, &nrChannels, 0);
-    if (data)
-    {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    }
-    else
-    {
-        std::cerr << "Failed to load texture" << std::endl;
-    }
-    stbi_image_free(data);
 
-    glGenTextures(1, &texture2);
-    glBindTexture(GL_TEXTURE_2D, texture2);
+    SetupFace(0, vertices_front, colors_front);
+    SetupFace(1, vertices_back, colors_back);
+    SetupFace(2, vertices_left, colors_left);
+    SetupFace(3, vertices_right, colors_right);
 
-    // Set the texture wrapping parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    // every cube draws 8 faces of 6 vertices
+    size_t verticesPerFrame = (size_t)cubeGrid * cubeGrid * 8 * 6;
+    printf("cube grid %dx%d: %zu -> %zu vertex bytes fetched per frame\n", cubeGrid, cubeGrid,
+           verticesPerFrame * 8 * sizeof(float), verticesPerFrame * 16);
 
-    // Set texture filtering parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    // Load image, create texture and generate mipmaps
-    data = stbi_load("textures/pollock2.jpg", &width, &height, &nrChannels, 0);
-    if (data)
-    {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    }
-    else
-    {
-        std::cerr << "Failed to load texture" << std::endl;
-    }
-    stbi_image_free(data);
+    // Load (or share) textures, create mipmaps
+    texture1 = AcquireTexture("textures/pollock.jpg");
+    texture2 = AcquireTexture("textures/pollock2.jpg");
 }
 
 void myInit()
@@ -271,85 +238,241 @@ void myInit()
     // inform GLSL
     int transform_matrix_location = glGetUniformLocation(shaderProgram, "projection");
     glUniformMatrix4fv(transform_matrix_location, 1, GL_FALSE, glm::value_ptr(myprojectionmatrix));
+    modelLocation = glGetUniformLocation(shaderProgram, "modeltrans");
+    useTextureLocation = glGetUniformLocation(shaderProgram, "useTextureFlag");
     //glEnable(GL_CULL_FACE);
     // Specify which faces to cull (GL_BACK, GL_FRONT, or GL_FRONT_AND_BACK)
     //glCullFace(GL_FRONT_AND_BACK); // 
 }
 
-void drawFace(unsigned int VAO, bool useTexture, int textureChoice)
+RenderQueue renderQueue;
+WorkerPool workerPool;
+std::vector<CommandList> commandLists; // one per recording thread
+FrameArena frameArena; // command records and model matrices, one sub-arena per recording thread
+const int kDrawsPerCube = 8;
+
+// The largest range ParallelFor hands one thread.
+int CubesPerThread()
+{
+    int threads = WorkerThreadCount(workerPool);
+    return (cubeGrid * cubeGrid + threads - 1) / threads;
+}
+
+// Records one face; the queue decides the final order. textureChoice 0 = vertex colors.
+void drawFace(CommandList& list, const float* model, unsigned int VAO, GLenum cullFace, int textureChoice)
+{
+    unsigned int texture = textureChoice == 1 ? texture1 : (textureChoice == 2 ? texture2 : 0);
+    DrawRecord record;
+    record.key = MakeSortKey(0, false, shaderProgram, cullFace, texture, VAO, 0.0f);
+    record.program = shaderProgram;
+    record.vao = VAO;
+    record.textures[0] = texture;
+    record.textures[1] = 0;
+    record.mode = GL_TRIANGLES;
+    record.first = 0;
+    record.count = 6;
+    record.indexType = 0;
+    record.cullFace = cullFace;
+    record.modelLocation = modelLocation;
+    record.model = model;
+    record.flagLocation = useTextureLocation;
+    record.flagValue = texture != 0;
+    RecordDraw(list, record);
+}
+
+// --mesh: one indexed draw instead of the cube's faces, both sides (the winding of the file is unknown).
+void drawMesh(CommandList& list, const float* model)
 {
-    glBindVertexArray(VAO);
-    if (useTexture)
+    unsigned int texture = meshTextured ? texture1 : 0;
+    DrawRecord record;
+    record.key = MakeSortKey(0, false, shaderProgram, 0, texture, meshVAO, 0.0f);
+    record.program = shaderProgram;
+    record.vao = meshVAO;
+    record.textures[0] = texture;
+    record.textures[1] = 0;
+    record.mode = GL_TRIANGLES;
+    record.first = 0;
+    record.count = meshIndexCount;
+    record.indexType = meshIndexType;
+    record.cullFace = 0;
+    record.modelLocation = modelLocation;
+    record.model = model;
+    record.flagLocation = useTextureLocation;
+    record.flagValue = texture != 0;
+    RecordDraw(list, record);
+}
+
+// Worker thread: builds the model matrices and draw records of cubes [begin, end). No GL calls.
+void RecordCubes(void* context, int worker, int begin, int end)
+{
+    float angle = *(float*)context;
+    CommandList& list = commandLists[worker];
+    float spacing = (ymax - ymin) / cubeGrid;
+    for (int cube = begin; cube < end; cube++)
     {
-        glUniform1i(glGetUniformLocation(shaderProgram, "useTextureFlag"), 1);  // Set useTextureFlag to true
-        if (textureChoice == 1)
-            glBindTexture(GL_TEXTURE_2D, texture1);  // Bind first texture
-        else
-            glBindTexture(GL_TEXTURE_2D, texture2);  // Bind second texture
+        float* model = CommandUniformAlloc(list, 16);
+        if (!model)
+            return;
+        glm::vec3 position(ymin + spacing * (cube % cubeGrid + 0.5f), ymin + spacing * (cube / cubeGrid + 0.5f), 0.0f);
+        glm::mat4 mymodelmatrix = CubeModelMatrix(position, 1.0f / cubeGrid, angle);
+        if (meshVAO)
+        {
+            memcpy(model, glm::value_ptr(mymodelmatrix * meshFit), 16 * sizeof(float));
+            drawMesh(list, model);
+            continue;
+        }
+        memcpy(model, glm::value_ptr(mymodelmatrix), 16 * sizeof(float));
+
+        // Front face: textured outside, colored inside
+        drawFace(list, model, VAOs[0], GL_BACK, 1);
+        drawFace(list, model, VAOs[0], GL_FRONT, 0);
+
+        // Left face
+        drawFace(list, model, VAOs[2], GL_BACK, 2);
+        drawFace(list, model, VAOs[2], GL_FRONT, 0);
+
+        // Right face
+        drawFace(list, model, VAOs[3], GL_BACK, 0);
+        drawFace(list, model, VAOs[3], GL_FRONT, 2);
+
+        // Back face
+        drawFace(list, model, VAOs[1], GL_FRONT, 1);
+        drawFace(list, model, VAOs[1], GL_BACK, 0);
     }
-    else
+}
+
+void mydisplay(float angle)
+{
+    int cubes = cubeGrid * cubeGrid;
+    BeginArenaFrame(frameArena);
+    for (int thread = 0; thread < (int)commandLists.size(); thread++)
+        ResetCommandList(commandLists[thread], frameArena, thread, (size_t)CubesPerThread() * kDrawsPerCube);
+
+    // record in parallel, replay on this (the GL) thread
+    BeginHudScope("record");
+    ParallelFor(workerPool, cubes, RecordCubes, &angle);
+    EndHudScope();
+
+    BeginHudScope("queue");
+    if (meshVAO && !meshTextured)
+        glVertexAttrib3fv(2, meshColor); // the mesh has no color attribute: aColor reads this
+    ClearRenderQueue(renderQueue);
+    MergeCommandLists(renderQueue, commandLists.data(), (int)commandLists.size());
+    ExecuteRenderQueue(renderQueue);
+    EndHudScope();
+    HudCountDraws(renderQueue.stats.draws);
+    glDisable(GL_CULL_FACE);
+}
+
+OverdrawView overdraw; // --overdraw
+double lastStatsTime = 0.0;
+
+// Scene entry points, used by main below and by scene_host.cpp
+void SceneInit(int width, int height)
+{
+    Wwidth0 = width;
+    Wheight0 = height;
+    InitMyShaders();
+    if (overdraw.enabled)
     {
-        glUniform1i(glGetUniformLocation(shaderProgram, "useTextureFlag"), 0);  // Set useTextureFlag to false
-        glBindTexture(GL_TEXTURE_2D, 0);  // Ensure no texture is bound
+        ReleaseProgram(shaderProgram);
+        shaderProgram = CreateOverdrawProgram(vertexShaderSource);
+        InitOverdrawView(overdraw, Wwidth0, Wheight0);
     }
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    SetupVerticesData();
+    myInit();
+    StartWorkerPool(workerPool);
+    commandLists.resize(WorkerThreadCount(workerPool));
+    size_t cubeBytes = kDrawsPerCube * sizeof(DrawRecord) + 16 * sizeof(float) + kFrameArenaAlignment;
+    InitFrameArena(frameArena, CubesPerThread() * cubeBytes + kFrameArenaAlignment, WorkerThreadCount(workerPool));
 }
 
-void mydisplay(float angle)
+void SceneFrame(double time)
 {
-    glEnable(GL_CULL_FACE);
-
-    glm::mat4 myIdentitymatrix = glm::mat4(1.0f);
-    float x = 1.0f; // sin(angle / 5);
-    glm::mat4 mymodelmatrix = glm::rotate(myIdentitymatrix, glm::radians(angle), glm::vec3(1.0f, x, 1.0f));
-    int transform_matrix_location = glGetUniformLocation(shaderProgram, "modeltrans");
-    glUniformMatrix4fv(transform_matrix_location, 1, GL_FALSE, glm::value_ptr(mymodelmatrix));
-
-    // Draw front face
-    glCullFace(GL_BACK);
-    glPolygonMode(GL_FRONT, GL_FILL);
-    drawFace(VAOs[0], true, 1);
-
-    // Draw back face
-    glCullFace(GL_FRONT);
-    glPolygonMode(GL_BACK, GL_FILL);
-    drawFace(VAOs[0], false, 1);
-
-    // Draw left face
-    glCullFace(GL_BACK);
-    glPolygonMode(GL_FRONT, GL_FILL);
-    drawFace(VAOs[2], true, 2);
-
-    // Draw back face
-    glCullFace(GL_FRONT);
-    glPolygonMode(GL_BACK, GL_FILL);
-    drawFace(VAOs[2], false, 2);
-
-    // Draw right face
-    glCullFace(GL_BACK);
-    glPolygonMode(GL_FRONT, GL_FILL);
-    drawFace(VAOs[3], false, 2);
-
-    // Draw back face
-    glCullFace(GL_FRONT);
-    glPolygonMode(GL_BACK, GL_FILL);
-    drawFace(VAOs[3], true, 2);
-
-    // Draw back face
-    glCullFace(GL_FRONT);
-    glPolygonMode(GL_BACK, GL_FILL);
-    drawFace(VAOs[1], true, 1);
-
-    // Draw front face
-    glCullFace(GL_BACK);
-    glPolygonMode(GL_FRONT, GL_FILL);
-    drawFace(VAOs[1], false, 1);
+    // state other scenes in the same context may have changed
+    glDisable(GL_BLEND);
+    glClearColor(0.2, 0.2, 0.4, 0.0);
 
-    glDisable(GL_CULL_FACE);
+    if (overdraw.enabled)
+        BeginOverdrawFrame(overdraw);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LEQUAL);
+    float angle = time * 190;
+  
+    if (overdraw.enabled)
+        BeginOverdrawPass(overdraw, "cube");
+    mydisplay(angle);
+    if (overdraw.enabled)
+    {
+        EndOverdrawPass(overdraw);
+        EndOverdrawFrame(overdraw, time);
+    }
+
+    if (time - lastStatsTime > 5.0)
+    {
+        PrintRenderQueueStats(renderQueue, "cube queue");
+        PrintFrameArenaStats(frameArena, "cube");
+        lastStatsTime = time;
+    }
+}
+
+void SceneShutdown()
+{
+    StopWorkerPool(workerPool);
+    PrintFrameArenaStats(frameArena, "cube");
+    DeleteGLObjects(GL_VERTEX_ARRAY, 4, VAOs);
+    for (int face = 0; face < 4; face++)
+        ReleaseBuffer(VBOs[face]);
+    if (meshVAO)
+    {
+        DeleteGLObjects(GL_VERTEX_ARRAY, 1, &meshVAO);
+        unsigned int meshBuffers[2] = { meshVBO, meshEBO };
+        DeleteGLObjects(GL_BUFFER, 2, meshBuffers);
+        meshVAO = meshVBO = meshEBO = 0;
+    }
+    ReleaseTexture(texture1);
+    ReleaseTexture(texture2);
+    ReleaseProgram(shaderProgram);
+    DestroyOverdrawView(overdraw);
 }
 
-int main(void)
+} // namespace cube
+
+#ifndef SCENE_HOST
+int main(int argc, char** argv)
 {
+    using namespace cube;
+    const char* capturePath = NULL;
+    double dynresTarget = 0.0; // ms, 0 = off
+    const char* dynresLog = NULL;
+    bool hud = false;
+    bool checkHeap = false; // --heap-check: steady-state frames must not allocate
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--cubes") == 0 && i + 1 < argc)
+            cubeGrid = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--mesh") == 0 && i + 1 < argc)
+            meshPath = argv[++i];
+        else if (strcmp(argv[i], "--overdraw") == 0)
+            overdraw.enabled = true;
+        else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+            capturePath = argv[++i];
+        else if (strcmp(argv[i], "--hud") == 0)
+            hud = true;
+        else if (strcmp(argv[i], "--heap-check") == 0)
+            checkHeap = true;
+        else if (strcmp(argv[i], "--dynres") == 0 && i + 1 < argc)
+        {
+            dynresTarget = atof(argv[++i]);
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                dynresLog = argv[++i];
+        }
+    }
+    if (cubeGrid < 1)
+        cubeGrid = 1;
+
     // start GL context and O/S window using the GLFW helper library
     if (!glfwInit())
     {
@@ -367,28 +490,46 @@ int main(void)
     glfwMakeContextCurrent(window);
     glewInit();
 
-    InitMyShaders();
-    SetupVerticesData();
-    myInit();
-    glEnable(GL_CULL_FACE);
+    SceneInit(Wwidth0, Wheight0);
+    if (meshPath && !meshVAO)
+        return 1;
+    FrameCapture capture;
+    if (capturePath && !InitFrameCapture(capture, capturePath, Wwidth0, Wheight0))
+        return 1;
+    DynamicResolution dynres;
+    if (dynresTarget > 0.0 && !overdraw.enabled && !InitDynamicResolution(dynres, Wwidth0, Wheight0, dynresTarget, dynresLog))
+        return 1;
+    if (hud && !InitPerfHud(Wwidth0, Wheight0))
+        return 1;
+    PrintGLTotals("after init");
+    if (checkHeap)
+        BeginHeapCheck();
     /* Loop until the user closes the window */
     while (!glfwWindowShouldClose(window))
     {
         /* Render here */
-        glClear(GL_DEPTH_BUFFER_BIT);
-        glClear(GL_COLOR_BUFFER_BIT);
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
-        float time = glfwGetTime();
-        float angle = time * 190;
-      
-        mydisplay(angle);
+        BeginHudFrame();
+        if (dynres.enabled)
+            BeginDynamicResolution(dynres);
+        BeginHudScope("scene");
+        SceneFrame(glfwGetTime());
+        EndHudScope();
+        if (dynres.enabled)
+            EndDynamicResolution(dynres);
+        DrawHud();
+        CaptureFrame(capture);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
+        CountFrameHeap();
     }
+    FinishFrameCapture(capture);
+    DestroyDynamicResolution(dynres);
+    DestroyPerfHud();
+    SceneShutdown();
+    ReportGLLeaks();
     // close GL context and any other GLFW resources
     glfwTerminate();
-    return 0;
+    return EndHeapCheck() ? 0 : 1;
 }
-
+#endif
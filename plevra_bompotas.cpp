@@ -1,15 +1,41 @@
+#ifndef SCENE_HOST // the host counts heap allocations itself
+#define FRAME_ARENA_HEAP_COUNTER // --heap-check
+#endif
 #include "GL/glew.h" 
 #include "GL/glfw3.h" 
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
-
+#include "ResourceManager.h"
+#include "RenderQueue.h"
+#include "ProceduralMesh.h"
+#include "OverdrawView.h"
+#include "FrameCapture.h"
+#include "DynamicResolution.h"
+#include "PerfHud.h"
+#include "FrameArena.h"
+#include "StreamBuffer.h"
+#include "WeightedOIT.h"
+#include "VirtualTexture.h"
+#include "DemoKernels.h"
+
+#ifndef SCENE_HOST // the host compiles stb_image itself
 #define STB_IMAGE_IMPLEMENTATION
+#endif
 #include "stb_image.h" 
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <random>
+#include <string>
+#include <vector>
 
+namespace plevra {
 
 unsigned int Wwidth0 = 800, Wheight0 = 800;
 
@@ -17,9 +43,14 @@ unsigned int Wwidth0 = 800, Wheight0 = 800;
 const char* vertexShaderSource = "#version 330 core\n"
                                  "layout (location = 0) in vec3 aPos;\n"
                                  "layout (location = 1) in vec2 aTexCoord;\n"
+                                 "#ifdef INSTANCED\n"
+                                 "layout (location = 2) in mat4 aModel;\n"
+                                 "#define modeltrans aModel\n"
+                                 "#else\n"
+                                 "uniform mat4 modeltrans;\n"
+                                 "#endif\n"
                                  "out vec2 TexCoord;\n"
                                  "uniform mat4 projection;\n"
-                                 "uniform mat4 modeltrans;\n"
                                  "void main()\n"
                                  "{\n"
                                  "  TexCoord = aTexCoord;\n"
@@ -32,139 +63,74 @@ const char* fragmentShaderSource = "#version 330 core\n"
                                    "uniform sampler2D texture2;\n"
                                    "uniform float alpha1;\n"
                                    "uniform float alpha2;\n"
+                                   "#ifdef WEIGHTED_OIT\n"
+                                   "layout (location = 0) out vec4 accum;\n"
+                                   "layout (location = 1) out float accumWeight;\n"
+                                   "#else\n"
                                    "out vec4 FragColor;\n"
+                                   "#endif\n"
                                    "void main()\n"
                                    "{\n"
+                                   "#ifdef VIRTUAL_TEXTURE\n"
+                                   "    vec4 color1 = SampleVirtualTexture(TexCoord) * alpha1;\n"
+                                   "#else\n"
                                    "    vec4 color1 = texture(texture1, TexCoord) * alpha1;\n"
+                                   "#endif\n"
                                    "    vec4 color2 = texture(texture2, TexCoord) * alpha2;\n"
-                                   "    FragColor = color1 + color2 * (1.0 - alpha1);\n"
+                                   "    vec4 color = color1 + color2 * (1.0 - alpha1);\n"
+                                   "#ifdef WEIGHTED_OIT\n"
+                                   "    float a = clamp(color.a, 0.0, 1.0);\n"
+                                   "    float w = a * clamp(WEIGHTED_OIT_SCALE * pow(1.0 - gl_FragCoord.z, 3.0), 1e-2, WEIGHTED_OIT_SCALE);\n"
+                                   "    accum = vec4(color.rgb * w, a);\n"
+                                   "    accumWeight = w;\n"
+                                   "#else\n"
+                                   "    FragColor = color;\n"
+                                   "#endif\n"
                                    "}\n\0";
 
 unsigned int shaderProgram;
 unsigned int texture1, texture2;
 
+// --layers N: N translucent quads in one instanced draw, blended either after a CPU
+// back-to-front sort (default) or with weighted blended OIT (--oit), which needs no sort.
+int layerCount = 0;
+bool useOIT = false;
+bool benchmarkLayers = false; // --oit-bench
+unsigned int layerPrograms[2]; // sorted blending, weighted OIT
 
 void InitMyShaders()
 {
-    
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-    
-    
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-
-   
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-    
-    
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-
-  
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    
-  
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-    }
+    // compile + link, or load the program binary cached by a previous run
+    shaderProgram = AcquireProgram("plevra", vertexShaderSource, fragmentShaderSource);
+}
 
-    
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+void InitLayerShaders()
+{
+    char oitDefines[128];
+    snprintf(oitDefines, sizeof(oitDefines), "#define INSTANCED\n#define WEIGHTED_OIT\n#define WEIGHTED_OIT_SCALE %.1f\n",
+             kWeightedOITScale);
+    layerPrograms[0] = AcquireProgram("plevra layers", vertexShaderSource, fragmentShaderSource, "#define INSTANCED\n");
+    layerPrograms[1] = AcquireProgram("plevra layers OIT", vertexShaderSource, fragmentShaderSource, oitDefines);
 }
 
 float xmin = -2.0f, xmax = 2.0f, ymin = -2.0f, ymax = 2.0f, zmin = -2.0f, zmax = 2.0f;
 
 
-float vertices[] = {
-    -0.5f, -0.5f,  0.0f,  0.0f, 0.0f,
-     0.5f, -0.5f,  0.0f,  1.0f, 0.0f,
-     0.5f,  0.5f,  0.0f,  1.0f, 1.0f,
-     0.5f,  0.5f,  0.0f,  1.0f, 1.0f,
-    -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,
-    -0.5f, -0.5f,  0.0f,  0.0f, 0.0f
-};
-
 unsigned int VAO, VBO;
 
 void SetupVerticesData()
 {
     glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+    VBO = AcquireBuffer(kUnitQuad.data(), sizeof(kUnitQuad), "plevra quad"); // baked at build time
 
     glBindVertexArray(VAO);
+    GL_TRACK(GL_VERTEX_ARRAY, VAO, "plevra quad", 0);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    
-    glGenTextures(1, &texture1);
-    glBindTexture(GL_TEXTURE_2D, texture1);
-
-    
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-    
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    
-    int width, height, nrChannels;
-    unsigned char *data = stbi_load("textures/pollock2.jpg", &width, &height, &nrChannels, 0);
-    if (data)
-    {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    }
-    else
-    {
-        std::cerr << "Failed to load texture" << std::endl;
-    }
-    stbi_image_free(data);
+    TexturedLayout::Apply();
 
-    glGenTextures(1, &texture2);
-    glBindTexture(GL_TEXTURE_2D, texture2);
-
-    
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    data = stbi_load("textures/monalisa.jpg", &width, &height, &nrChannels, 0);
-    if (data)
-    {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    }
-    else
-    {
-        std::cerr << "Failed to load texture" << std::endl;
-    }
-    stbi_image_free(data);
+    // Load (or share) textures, create mipmaps
+    texture1 = AcquireTexture("textures/pollock2.jpg");
+    texture2 = AcquireTexture("textures/monalisa.jpg");
 }
 
 void myInit()
@@ -182,32 +148,444 @@ void myInit()
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
-void drawFace(float alpha1, float alpha2)
+RenderQueue renderQueue;
+glm::mat4 mymodelmatrix;
+
+// --virtual file.vtex: texture1 is replaced by a virtual texture (VirtualTexture.h) streamed
+// from the memory-mapped file, so the image can be far larger than any GPU texture. The view
+// zooms in and out (up to kVirtualMaxZoom) so ever finer levels get requested.
+const char* virtualPath = NULL;
+VirtualTextureFile virtualFile;
+VirtualTexture virtualTexture;
+unsigned int virtualFeedbackProgram;
+const float kVirtualMaxZoom = 64.0f;
+float virtualZoom = 1.0f;
+double lastVirtualReport = 0.0;
+
+bool SetupVirtualTexture()
+{
+    if (!OpenVirtualTextureFile(virtualPath, virtualFile))
+        return false;
+    if (!InitVirtualTexture(virtualTexture, virtualFile, Wwidth0, Wheight0))
+    {
+        DestroyVirtualTexture(virtualTexture);
+        CloseVirtualTextureFile(virtualFile);
+        return false;
+    }
+    ReleaseProgram(shaderProgram);
+    std::string fragmentSource = VirtualTextureFragmentSource(fragmentShaderSource);
+    shaderProgram = AcquireProgram("plevra virtual", vertexShaderSource, fragmentSource.c_str(), "#define VIRTUAL_TEXTURE\n");
+    SetVirtualTextureUniforms(virtualTexture, shaderProgram, 0, 2);
+    virtualFeedbackProgram = CreateVirtualFeedbackProgram(virtualTexture, vertexShaderSource);
+    glm::mat4 myprojectionmatrix = glm::ortho(xmin, xmax, ymin, ymax, zmin, zmax);
+    for (unsigned int program : { shaderProgram, virtualFeedbackProgram })
+    {
+        glUseProgram(program);
+        glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(myprojectionmatrix));
+    }
+    glUseProgram(shaderProgram);
+    return true;
+}
+
+// Renders the page ids of the quad and streams in what last frame's ids asked for.
+void VirtualFeedbackPass()
 {
+    BeginHudScope("VT feedback");
+    BeginVirtualFeedback(virtualTexture);
+    glUseProgram(virtualFeedbackProgram);
+    glUniformMatrix4fv(glGetUniformLocation(virtualFeedbackProgram, "modeltrans"), 1, GL_FALSE,
+                       glm::value_ptr(mymodelmatrix));
     glBindVertexArray(VAO);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
+    EndVirtualFeedback(virtualTexture);
+    EndHudScope();
+    BindVirtualTexture(virtualTexture, 0, 2);
+    glUseProgram(shaderProgram);
+    HudCountDraws(1);
+}
+
+void drawFace(float alpha1, float alpha2)
+{
     glUniform1i(glGetUniformLocation(shaderProgram, "texture1"), 0); // Set texture1 to texture unit 0
     glUniform1i(glGetUniformLocation(shaderProgram, "texture2"), 1); // Set texture2 to texture unit 1
     glUniform1f(glGetUniformLocation(shaderProgram, "alpha1"), alpha1); // Set alpha1 value
     glUniform1f(glGetUniformLocation(shaderProgram, "alpha2"), alpha2); // Set alpha2 value
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture1); // Bind first texture
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, texture2); // Bind second texture
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    // blended quad: sorted back-to-front by the distance of its center from the near plane
+    glm::vec4 center = mymodelmatrix * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    float depth = (-center.z - zmin) / (zmax - zmin);
+
+    DrawRecord record;
+    unsigned int firstTexture = virtualTexture.enabled ? virtualTexture.cacheTexture : texture1;
+    record.key = MakeSortKey(0, true, shaderProgram, 0, firstTexture, VAO, depth);
+    record.program = shaderProgram;
+    record.vao = VAO;
+    record.textures[0] = firstTexture; // Bind first texture
+    record.textures[1] = texture2; // Bind second texture
+    record.mode = GL_TRIANGLES;
+    record.first = 0;
+    record.count = 6;
+    record.indexType = 0;
+    record.cullFace = 0;
+    record.modelLocation = glGetUniformLocation(shaderProgram, "modeltrans");
+    record.model = glm::value_ptr(mymodelmatrix);
+    record.flagLocation = -1;
+    record.flagValue = 0;
+    SubmitDraw(renderQueue, record);
 }
 
 void mydisplay(float angle, float alpha1, float alpha2)
 {
     glm::mat4 myIdentitymatrix = glm::mat4(1.0f);
-    glm::mat4 mymodelmatrix = glm::rotate(myIdentitymatrix, glm::radians(angle), glm::vec3(1.0f, 0.0f, 1.0f));
-    int transform_matrix_location = glGetUniformLocation(shaderProgram, "modeltrans");
-    glUniformMatrix4fv(transform_matrix_location, 1, GL_FALSE, glm::value_ptr(mymodelmatrix));
+    mymodelmatrix = QuadModelMatrix(angle);
+    if (virtualTexture.enabled)
+    {
+        // zoom in x and y only: the tilted quad stays inside the depth range
+        mymodelmatrix = glm::scale(myIdentitymatrix, glm::vec3(virtualZoom, virtualZoom, 1.0f)) * mymodelmatrix;
+        VirtualFeedbackPass();
+    }
 
+    ClearRenderQueue(renderQueue);
     drawFace(alpha1, alpha2);
+    ExecuteRenderQueue(renderQueue);
+    HudCountDraws(renderQueue.stats.draws);
+}
+
+// Layers: one model matrix per instance, streamed every frame.
+struct LayerInstance
+{
+    float model[16];
+};
+
+using LayerInstanceLayout = VertexLayout<LayerInstance, Attrib<2, float, 4>, Attrib<3, float, 4>, Attrib<4, float, 4>,
+                                         Attrib<5, float, 4>>;
+// one attribute per column of the matrix
+static_assert(LayerInstanceLayout::MatchesMembers({ offsetof(LayerInstance, model[0]), offsetof(LayerInstance, model[4]),
+                                                    offsetof(LayerInstance, model[8]), offsetof(LayerInstance, model[12]) }),
+              "LayerInstanceLayout does not follow LayerInstance");
+
+struct Layer
+{
+    float x, y, z, size, phase, speed;
+};
+
+std::vector<Layer> layers;
+FrameArena frameArena; // sorted path: this frame's models and their depth order
+unsigned int layerVAO;
+StreamBuffer layerStream;
+WeightedOIT oit;
+double layerBuildMs = 0.0; // CPU time of the last BuildLayerInstances (models, sort, upload)
+unsigned long long layerFrames = 0;
+double layerBuildMsSum = 0.0, lastLayerReport = 0.0;
+
+void SetupLayers(int maxLayers)
+{
+    std::mt19937 random(1234); // same layers every run
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    layers.resize(maxLayers);
+    for (Layer& layer : layers)
+    {
+        layer.x = (unit(random) * 2.0f - 1.0f) * xmax * 0.8f;
+        layer.y = (unit(random) * 2.0f - 1.0f) * ymax * 0.8f;
+        layer.z = (unit(random) * 2.0f - 1.0f) * 1.2f;
+        layer.size = 0.5f + unit(random);
+        layer.phase = unit(random) * 360.0f;
+        layer.speed = 0.5f + unit(random);
+    }
+    InitFrameArena(frameArena, (size_t)maxLayers * (sizeof(glm::mat4) + sizeof(int)) + 2 * kFrameArenaAlignment);
+
+    glGenVertexArrays(1, &layerVAO);
+    glBindVertexArray(layerVAO);
+    GL_TRACK(GL_VERTEX_ARRAY, layerVAO, "plevra layers", 0);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    TexturedLayout::Apply();
+    glBindVertexArray(0);
+    InitStreamBuffer(layerStream, (GLsizeiptr)maxLayers * sizeof(LayerInstance));
+
+    InitLayerShaders();
+    glm::mat4 myprojectionmatrix = glm::ortho(xmin, xmax, ymin, ymax, zmin, zmax);
+    for (unsigned int program : layerPrograms)
+    {
+        glUseProgram(program);
+        glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(myprojectionmatrix));
+        glUniform1i(glGetUniformLocation(program, "texture1"), 0);
+        glUniform1i(glGetUniformLocation(program, "texture2"), 1);
+        // fainter than the single quad, so the layers behind stay visible
+        glUniform1f(glGetUniformLocation(program, "alpha1"), 0.15f);
+        glUniform1f(glGetUniformLocation(program, "alpha2"), 0.3f);
+    }
+    InitWeightedOIT(oit, Wwidth0, Wheight0);
+}
+
+// Writes this frame's instances into the stream buffer and returns their byte offset, or -1.
+// The sorted path orders them back to front (farthest center first); the OIT path writes
+// them straight into the mapped buffer in whatever order they come.
+GLintptr BuildLayerInstances(float angle, int count, bool sorted)
+{
+    auto start = std::chrono::steady_clock::now();
+    GLintptr offset = 0;
+    LayerInstance* mapped = (LayerInstance*)StreamAlloc(layerStream, (GLsizeiptr)count * sizeof(LayerInstance),
+                                                        sizeof(LayerInstance), &offset);
+    if (!mapped)
+        return -1;
+    // sorted path: models are computed first, written in depth order
+    glm::mat4* models = sorted ? ArenaAllocArray<glm::mat4>(frameArena, count) : NULL;
+    int* order = sorted ? ArenaAllocArray<int>(frameArena, count) : NULL;
+    if (sorted && (!models || !order))
+    {
+        StreamUnmap(layerStream);
+        return -1;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        const Layer& layer = layers[i];
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(layer.x, layer.y, layer.z));
+        model = glm::rotate(model, glm::radians(angle * layer.speed + layer.phase), glm::vec3(1.0f, 0.0f, 1.0f));
+        model = glm::scale(model, glm::vec3(layer.size));
+        if (sorted)
+            models[i] = model;
+        else
+            memcpy(mapped[i].model, glm::value_ptr(model), sizeof(LayerInstance));
+    }
+    if (sorted)
+    {
+        // the depth of a center grows as its z falls (ortho, looking down -z)
+        for (int i = 0; i < count; i++)
+            order[i] = i;
+        std::sort(order, order + count, [models](int a, int b) { return models[a][3].z < models[b][3].z; });
+        for (int i = 0; i < count; i++)
+            memcpy(mapped[i].model, glm::value_ptr(models[order[i]]), sizeof(LayerInstance));
+    }
+    StreamUnmap(layerStream);
+    layerBuildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return offset;
+}
+
+void DrawLayers(float angle, int count, bool weighted)
+{
+    BeginStreamFrame(layerStream);
+    BeginArenaFrame(frameArena);
+    BeginHudScope(weighted ? "OIT build" : "sort build");
+    GLintptr offset = BuildLayerInstances(angle, count, !weighted);
+    EndHudScope();
+    if (offset >= 0)
+    {
+        glDepthMask(GL_FALSE); // every layer has to reach the blend, whatever was drawn in front of it
+        BeginHudScope("layers");
+        if (weighted)
+            BeginWeightedOIT(oit);
+        glUseProgram(layerPrograms[weighted ? 1 : 0]);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, texture1);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, texture2);
+        glActiveTexture(GL_TEXTURE0);
+        glBindVertexArray(layerVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, layerStream.buffer);
+        LayerInstanceLayout::Apply(offset, 1);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, count);
+        glBindVertexArray(0);
+        if (weighted)
+            ResolveWeightedOIT(oit);
+        EndHudScope();
+        HudCountDraws(weighted ? 2 : 1);
+        glDepthMask(GL_TRUE);
+    }
+    EndStreamFrame(layerStream);
+}
+
+// --oit-bench: every layer count is drawn kBenchFrames times with each path. glFinish after
+// every frame puts the GPU time into the frame time; the CPU column is BuildLayerInstances alone.
+const int kBenchLayerCounts[] = { 64, 256, 1024, 4096, 16384 };
+const int kBenchFrames = 60;
+
+void RunLayerBenchmark()
+{
+    printf("%8s  %12s %14s  %12s %14s\n", "layers", "sorted cpu", "sorted frame", "OIT cpu", "OIT frame");
+    for (int count : kBenchLayerCounts)
+    {
+        if (count > (int)layers.size())
+            break;
+        double cpuMs[2], frameMs[2];
+        for (int mode = 0; mode < 2; mode++)
+        {
+            DrawLayers(0.0f, count, mode == 1); // warm up: programs, driver state
+            glFinish();
+            double buildSum = 0.0;
+            auto start = std::chrono::steady_clock::now();
+            for (int frame = 0; frame < kBenchFrames; frame++)
+            {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                DrawLayers(frame * 2.0f, count, mode == 1);
+                buildSum += layerBuildMs;
+                glFinish();
+            }
+            frameMs[mode] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() /
+                            kBenchFrames;
+            cpuMs[mode] = buildSum / kBenchFrames;
+        }
+        printf("%8d  %9.3f ms %11.3f ms  %9.3f ms %11.3f ms\n", count, cpuMs[0], frameMs[0], cpuMs[1], frameMs[1]);
+    }
+}
+
+OverdrawView overdraw; // --overdraw
+
+// Scene entry points, used by main below and by scene_host.cpp
+void SceneInit(int width, int height)
+{
+    Wwidth0 = width;
+    Wheight0 = height;
+    InitMyShaders();
+    if (overdraw.enabled)
+    {
+        ReleaseProgram(shaderProgram);
+        shaderProgram = CreateOverdrawProgram(vertexShaderSource);
+        InitOverdrawView(overdraw, Wwidth0, Wheight0);
+    }
+    SetupVerticesData();
+    myInit();
+    if (virtualPath && !SetupVirtualTexture())
+        fprintf(stderr, "ERROR: --virtual %s failed, drawing the regular textures\n", virtualPath);
+    if (layerCount > 0)
+    {
+        SetupLayers(layerCount);
+        if (!benchmarkLayers)
+            printf("Layers: %d, %s\n", layerCount, useOIT ? "weighted blended OIT" : "sorted back to front on the CPU");
+    }
+}
+
+void SceneFrame(double time)
+{
+    // state other scenes in the same context may have changed
+    glUseProgram(shaderProgram);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glClearColor(0.2, 0.2, 0.4, 0.0);
+
+    if (overdraw.enabled)
+        BeginOverdrawFrame(overdraw);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LEQUAL);
+    float angle = time * 50;
+    float alpha1 = 0.4f; // Set alpha1 value between 0.0 and 1.0
+    float alpha2 = 0.8f; // Set alpha2 value between 0.0 and 1.0
+  
+    if (layerCount > 0)
+    {
+        DrawLayers(angle, layerCount, useOIT);
+        layerFrames++;
+        layerBuildMsSum += layerBuildMs;
+        if (time - lastLayerReport >= 1.0)
+        {
+            printf("Layers: %d %s, %.3f ms CPU per frame (instances%s)\n", layerCount, useOIT ? "OIT" : "sorted",
+                   layerBuildMsSum / layerFrames, useOIT ? "" : " + sort");
+            PrintFrameArenaStats(frameArena, "Layers");
+            layerFrames = 0;
+            layerBuildMsSum = 0.0;
+            lastLayerReport = time;
+        }
+        return;
+    }
+
+    if (virtualTexture.enabled)
+    {
+        virtualZoom = powf(kVirtualMaxZoom, 0.5f - 0.5f * cosf((float)time * 0.3f));
+        if (time - lastVirtualReport >= 5.0)
+        {
+            PrintVirtualTextureStats(virtualTexture, "Virtual texture");
+            lastVirtualReport = time;
+        }
+    }
+    if (overdraw.enabled)
+        BeginOverdrawPass(overdraw, "quad");
+    mydisplay(angle, alpha1, alpha2);
+    if (overdraw.enabled)
+    {
+        EndOverdrawPass(overdraw);
+        EndOverdrawFrame(overdraw, time);
+    }
+}
+
+void SceneShutdown()
+{
+    DeleteGLObjects(GL_VERTEX_ARRAY, 1, &VAO);
+    ReleaseBuffer(VBO);
+    ReleaseTexture(texture1);
+    ReleaseTexture(texture2);
+    ReleaseProgram(shaderProgram);
+    DestroyOverdrawView(overdraw);
+    if (virtualTexture.enabled)
+    {
+        PrintVirtualTextureStats(virtualTexture, "Virtual texture");
+        DeleteGLObjects(GL_PROGRAM, 1, &virtualFeedbackProgram);
+        DestroyVirtualTexture(virtualTexture);
+        CloseVirtualTextureFile(virtualFile);
+    }
+    if (layerCount > 0)
+    {
+        DeleteGLObjects(GL_VERTEX_ARRAY, 1, &layerVAO);
+        DestroyStreamBuffer(layerStream);
+        ReleaseProgram(layerPrograms[0]);
+        ReleaseProgram(layerPrograms[1]);
+        DestroyWeightedOIT(oit);
+        PrintFrameArenaStats(frameArena, "Layers");
+    }
 }
 
-int main(void)
+} // namespace plevra
+
+#ifndef SCENE_HOST
+int main(int argc, char** argv)
 {
+    using namespace plevra;
+    const char* capturePath = NULL;
+    double dynresTarget = 0.0; // ms, 0 = off
+    const char* dynresLog = NULL;
+    bool hud = false;
+    bool checkHeap = false; // --heap-check: steady-state frames must not allocate
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--overdraw") == 0)
+            overdraw.enabled = true;
+        else if (strcmp(argv[i], "--layers") == 0 && i + 1 < argc)
+            layerCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--oit") == 0)
+            useOIT = true;
+        else if (strcmp(argv[i], "--oit-bench") == 0)
+            benchmarkLayers = true;
+        else if (strcmp(argv[i], "--virtual") == 0 && i + 1 < argc)
+            virtualPath = argv[++i];
+        else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+            capturePath = argv[++i];
+        else if (strcmp(argv[i], "--hud") == 0)
+            hud = true;
+        else if (strcmp(argv[i], "--heap-check") == 0)
+            checkHeap = true;
+        else if (strcmp(argv[i], "--dynres") == 0 && i + 1 < argc)
+        {
+            dynresTarget = atof(argv[++i]);
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                dynresLog = argv[++i];
+        }
+    }
+    if (benchmarkLayers)
+        layerCount = kBenchLayerCounts[sizeof(kBenchLayerCounts) / sizeof(kBenchLayerCounts[0]) - 1];
+    else if (useOIT && layerCount <= 0)
+        layerCount = 1024;
+    if (layerCount > 0 && overdraw.enabled)
+    {
+        fprintf(stderr, "--overdraw does not support --layers, ignored\n");
+        overdraw.enabled = false;
+    }
+    if (virtualPath && (layerCount > 0 || overdraw.enabled))
+    {
+        fprintf(stderr, "--virtual does not support --layers or --overdraw, ignored\n");
+        virtualPath = NULL;
+    }
+
     // start GL context and O/S window using the GLFW helper library
     if (!glfwInit())
     {
@@ -225,33 +603,53 @@ int main(void)
     glfwMakeContextCurrent(window);
     glewInit();
 
-    InitMyShaders();
-    SetupVerticesData();
-    myInit();
+    SceneInit(Wwidth0, Wheight0);
+    if (benchmarkLayers)
+    {
+        RunLayerBenchmark();
+        SceneShutdown();
+        ReportGLLeaks();
+        glfwTerminate();
+        return 0;
+    }
+    FrameCapture capture;
+    if (capturePath && !InitFrameCapture(capture, capturePath, Wwidth0, Wheight0))
+        return 1;
+    DynamicResolution dynres;
+    if (dynresTarget > 0.0 && !overdraw.enabled && !InitDynamicResolution(dynres, Wwidth0, Wheight0, dynresTarget, dynresLog))
+        return 1;
+    if (hud && !InitPerfHud(Wwidth0, Wheight0))
+        return 1;
+    PrintGLTotals("after init");
 
+    if (checkHeap)
+        BeginHeapCheck();
     /* Loop until the user closes the window */
     while (!glfwWindowShouldClose(window))
     {
         /* Render here */
-        glClear(GL_DEPTH_BUFFER_BIT);
-        glClear(GL_COLOR_BUFFER_BIT);
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
-        float time = glfwGetTime();
-        float angle = time * 50;
-        float alpha1 = 0.4f; // Set alpha1 value between 0.0 and 1.0
-        float alpha2 = 0.8f; // Set alpha2 value between 0.0 and 1.0
-      
-        mydisplay(angle, alpha1, alpha2);
+        BeginHudFrame();
+        if (dynres.enabled)
+            BeginDynamicResolution(dynres);
+        BeginHudScope("scene");
+        SceneFrame(glfwGetTime());
+        EndHudScope();
+        if (dynres.enabled)
+            EndDynamicResolution(dynres);
+        DrawHud();
+        CaptureFrame(capture);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
+        CountFrameHeap();
     }
+    FinishFrameCapture(capture);
+    DestroyDynamicResolution(dynres);
+    DestroyPerfHud();
+    SceneShutdown();
+    ReportGLLeaks();
     // close GL context and any other GLFW resources
     glfwTerminate();
-    return 0;
+    return EndHeapCheck() ? 0 : 1;
 }
-
-
-
-
+#endif
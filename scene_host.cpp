@@ -0,0 +1,206 @@
+//Runs several of the demos in one window and one GL context, so they share
+//textures, programs and vertex buffers through ResourceManager.h.
+//
+//  scene_host square snow cube plevra asteroids split viewports
+//  scene_host --sequential 5 cube plevra        one scene at a time, switching every 5 s
+//  scene_host --hud cube asteroids              performance overlay, one timing scope per scene
+//  scene_host --heap-check cube plevra          report frames that still allocate after warm-up
+//
+//Build the demos together with the host:
+//  g++ -DSCENE_HOST scene_host.cpp square.cpp Snow.cpp opencube_Bompotas.cpp plevra_bompotas.cpp asteroids.cpp ...
+#define FRAME_ARENA_HEAP_COUNTER // --heap-check
+#include "GL/glew.h"
+#include "GL/glfw3.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "ResourceManager.h"
+#include "PerfHud.h"
+#include "FrameArena.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// entry points exported by each demo when built with SCENE_HOST
+namespace square {
+void SceneInit(int width, int height, unsigned int seed);
+void SceneFrame(double time);
+void SceneShutdown();
+void cursor_pos_callback(GLFWwindow* window, double xpos, double ypos);
+}
+namespace snow {
+void SceneInit(int width, int height, unsigned int seed);
+void SceneFrame(double time);
+void SceneShutdown();
+}
+namespace cube {
+void SceneInit(int width, int height);
+void SceneFrame(double time);
+void SceneShutdown();
+}
+namespace plevra {
+void SceneInit(int width, int height);
+void SceneFrame(double time);
+void SceneShutdown();
+}
+namespace asteroids {
+void SceneInit(int width, int height);
+void SceneFrame(double time);
+void SceneShutdown();
+}
+
+struct HostScene
+{
+    const char* name;
+    void (*init)(int width, int height);
+    void (*frame)(double time);
+    void (*shutdown)();
+    int x = 0, y = 0, width = 0, height = 0; // viewport, GL convention (origin bottom-left)
+};
+
+std::random_device rd;
+
+const HostScene availableScenes[] = {
+    { "square", [](int w, int h) { square::SceneInit(w, h, rd()); }, square::SceneFrame, square::SceneShutdown },
+    { "snow", [](int w, int h) { snow::SceneInit(w, h, rd()); }, snow::SceneFrame, snow::SceneShutdown },
+    { "cube", cube::SceneInit, cube::SceneFrame, cube::SceneShutdown },
+    { "plevra", plevra::SceneInit, plevra::SceneFrame, plevra::SceneShutdown },
+    { "asteroids", asteroids::SceneInit, asteroids::SceneFrame, asteroids::SceneShutdown },
+};
+
+std::vector<HostScene> scenes;
+int Wwidth0 = 800, Wheight0 = 800;
+
+// square is the only scene with input: forward the cursor in its viewport's coordinates
+void host_cursor_pos_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    for (const HostScene& scene : scenes)
+    {
+        if (strcmp(scene.name, "square") != 0)
+            continue;
+        double localX = xpos - scene.x;
+        double localY = ypos - (Wheight0 - scene.y - scene.height);
+        if (localX >= 0 && localY >= 0 && localX < scene.width && localY < scene.height)
+            square::cursor_pos_callback(window, localX, localY);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double switchSeconds = 0.0; // 0 = split viewports
+    bool hud = false;
+    bool checkHeap = false; // --heap-check: steady-state frames must not allocate
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--sequential") == 0 && i + 1 < argc)
+        {
+            switchSeconds = atof(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--hud") == 0)
+        {
+            hud = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--heap-check") == 0)
+        {
+            checkHeap = true;
+            continue;
+        }
+        bool found = false;
+        for (const HostScene& scene : availableScenes)
+            if (strcmp(argv[i], scene.name) == 0)
+            {
+                scenes.push_back(scene);
+                found = true;
+            }
+        if (!found)
+            fprintf(stderr, "unknown scene %s (square, snow, cube, plevra, asteroids)\n", argv[i]);
+    }
+    if (scenes.empty())
+        scenes.assign(std::begin(availableScenes), std::end(availableScenes));
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "ERROR: could not start GLFW3\n");
+        return 1;
+    }
+    GLFWwindow* window = glfwCreateWindow(Wwidth0, Wheight0, "Scene host", NULL, NULL);
+    if (!window)
+    {
+        fprintf(stderr, "ERROR: could not open window with GLFW3\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glewInit();
+    glfwSetCursorPosCallback(window, host_cursor_pos_callback);
+    printf("Renderer: %s\n", glGetString(GL_RENDERER));
+
+    // lay the scenes out on a grid, or give each the whole window
+    int columns = 1;
+    while (columns * columns < (int)scenes.size())
+        columns++;
+    int rows = (int)(scenes.size() + columns - 1) / columns;
+    for (size_t i = 0; i < scenes.size(); i++)
+    {
+        HostScene& scene = scenes[i];
+        if (switchSeconds > 0.0)
+        {
+            scene.x = scene.y = 0;
+            scene.width = Wwidth0;
+            scene.height = Wheight0;
+            continue;
+        }
+        scene.width = Wwidth0 / columns;
+        scene.height = Wheight0 / rows;
+        scene.x = (int)(i % columns) * scene.width;
+        scene.y = Wheight0 - (int)(i / columns + 1) * scene.height;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (HostScene& scene : scenes)
+        scene.init(scene.width, scene.height);
+    printf("Loaded %zu scenes in %.2f ms\n", scenes.size(),
+           std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    PrintResourceStats();
+    if (hud && !InitPerfHud(Wwidth0, Wheight0))
+        return 1;
+    PrintGLTotals("after init");
+
+    if (checkHeap)
+        BeginHeapCheck();
+    while (!glfwWindowShouldClose(window))
+    {
+        double time = glfwGetTime();
+        BeginHudFrame();
+        glEnable(GL_SCISSOR_TEST); // keeps each scene's glClear inside its viewport (DrawHud turns it off)
+        for (size_t i = 0; i < scenes.size(); i++)
+        {
+            if (switchSeconds > 0.0 && i != (size_t)(time / switchSeconds) % scenes.size())
+                continue;
+            const HostScene& scene = scenes[i];
+            glViewport(scene.x, scene.y, scene.width, scene.height);
+            glScissor(scene.x, scene.y, scene.width, scene.height);
+            BeginHudScope(scene.name);
+            scene.frame(time);
+            EndHudScope();
+        }
+        DrawHud();
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+        CountFrameHeap();
+    }
+
+    DestroyPerfHud();
+    for (HostScene& scene : scenes)
+        scene.shutdown();
+    PrintResourceStats();
+    ReportGLLeaks();
+    glfwTerminate();
+    return EndHeapCheck() ? 0 : 1;
+}
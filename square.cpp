@@ -2,20 +2,36 @@
 // Opengl graphics
 //AEM:4435
 //Move the mouse to the squares and see them change position and colors.
+#ifndef SCENE_HOST // the host counts heap allocations itself
+#define FRAME_ARENA_HEAP_COUNTER // --heap-check
+#endif
 #include "GL/glew.h" 
 #include "GLFW/glfw3.h" 
 
 #include "glm/glm/glm.hpp"
 #include "glm/glm/gtc/matrix_transform.hpp"
 #include "glm/glm/gtc/type_ptr.hpp"
+#include "ResourceManager.h"
+#include "StreamBuffer.h"
+#include "VertexLayout.h"
+#include "InputRecorder.h"
+#include "FrameCapture.h"
+#include "DynamicResolution.h"
+#include "PerfHud.h"
+#include "FrameArena.h"
+#include "DamageTracker.h"
+#include "DemoKernels.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <random>
 #include <iostream>
 
+namespace square {
 
 float xmin = -10, xmax = 10.0, ymin = -10.0, ymax = 10.0;
 float plevra = 1.0f;
-std::random_device rd;
-std::mt19937 gen(rd());
+std::mt19937 gen; // seeded in main from the input recorder, so --replay sees the same squares
 float generateRandomPos() {
     std::uniform_real_distribution<float> posdistribution(xmin+plevra, xmax-plevra);
     return posdistribution(gen);
@@ -49,51 +65,62 @@ unsigned int shaderProgram;
 
 void InitMyShaders()
 {
-    // vertex shader
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-    // fragment shader
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-    // link shaders
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    // delete shaders
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    // compile + link, or load the program binary cached by a previous run
+    shaderProgram = AcquireProgram("square", vertexShaderSource, fragmentShaderSource);
 }
 
 
 
 
-float initialX = generateRandomPos();
-float initialY = generateRandomPos();
-float vertices[] = {
+float initialX, initialY;
+float vertices[12];
+
+// Moves the square to a new random position
+void PlaceSquare()
+{
+    initialX = generateRandomPos();
+    initialY = generateRandomPos();
+    float corners[] = {
         initialX-plevra, initialY-plevra, 0.0f, 
          initialX-plevra, initialY+plevra, 0.0f, 
          initialX+plevra,  initialY+plevra, 0.0f, 
          initialX+plevra,  initialY-plevra, 0.0f 
-};
+    };
+    memcpy(vertices, corners, sizeof(vertices));
+}
+
+// --on-demand: draw only when the square moves, and only the pixels it left and entered
+bool onDemand = false;
+DirtyRegion damage;
+RetainedFrame retained;
+unsigned int inputEvents = 0; // cursor events so far, for the idle / interactive split
+const double kIdleWaitSeconds = 1.0; // longest block in glfwWaitEventsTimeout
+
+// Window pixels covered by the square, plus one on every side for rasterization rounding.
+DirtyRect SquareRect()
+{
+    float x0 = (initialX - plevra - xmin) / (xmax - xmin) * Wwidth0;
+    float x1 = (initialX + plevra - xmin) / (xmax - xmin) * Wwidth0;
+    float y0 = (initialY - plevra - ymin) / (ymax - ymin) * Wheight0;
+    float y1 = (initialY + plevra - ymin) / (ymax - ymin) * Wheight0;
+    int left = (int)floorf(x0) - 1, bottom = (int)floorf(y0) - 1;
+    return { left, bottom, (int)ceilf(x1) + 1 - left, (int)ceilf(y1) + 1 - bottom };
+}
 //-----------------------------------------------------
 
 
-unsigned int VBO, VAO;
+unsigned int VAO;
+StreamBuffer streamVBO; // the square is re-streamed every frame, see main loop
 
 void SetupVerticesData()
 {
   
     glGenVertexArrays(1, &VAO);
     glBindVertexArray(VAO);
+    GL_TRACK(GL_VERTEX_ARRAY, VAO, "square", 0);
     
-    glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), 0);
-    glEnableVertexAttribArray(0);
+    InitStreamBuffer(streamVBO, 4096);
+    PositionLayout::Apply();
 }
 
 
@@ -117,38 +144,31 @@ void myInit()
 }
 
 
-void cursor_pos_callback(GLFWwindow* window, double xpos, double ypos)
+InputRecorder recorder; // --record / --replay / --timing / --headless
+
+void cursor_pos_callback(GLFWwindow* /*window*/, double xpos, double ypos)
 {
+    RecordCursor(recorder, xpos, ypos);
+    inputEvents++;
     glm::vec3 color;
-    // Get the cursor position relative to the window
-    double x, y;
-    glfwGetCursorPos(window, &x, &y);
+    // Cursor position relative to the window (from the event, so a replay can drive it)
+    double x = xpos, y = ypos;
 
     // Convert cursor position to OpenGL coordinates
-    float mouse_x = (2.0f * x) / Wwidth0 - 1.0f;
-    float mouse_y = 1.0f - (2.0f * y) / Wheight0;
+    float mouse_x, mouse_y;
+    CursorToClip(x, y, Wwidth0, Wheight0, mouse_x, mouse_y);
 
     // Calculate color based on mouse position
     
-    if (mouse_x >= (initialX - plevra) / xmax && mouse_x <= (initialX + plevra) / xmax &&
-        mouse_y >= (initialY - plevra) / xmax && mouse_y <= (initialY + plevra) / xmax) {
-        // Regenerate the position of the square
-        initialX = generateRandomPos();
-        initialY = generateRandomPos();
+    if (SquareHit(mouse_x, mouse_y, initialX, initialY, plevra, xmax)) {
+        // Regenerate the position of the square and update vertices
+        if (onDemand)
+            MarkDirty(damage, SquareRect()); // where it was
+        PlaceSquare();
+        if (onDemand)
+            MarkDirty(damage, SquareRect()); // where it is now
         // Generate a new color
         color = glm::vec3(generateRandomColor(), generateRandomColor(), generateRandomColor());
-        // Update vertices
-        vertices[0] = initialX - plevra; 
-        vertices[1] = initialY - plevra; 
-        vertices[3] = initialX - plevra; 
-        vertices[4] = initialY + plevra; 
-        vertices[6] = initialX + plevra; 
-        vertices[7] = initialY + plevra; 
-        vertices[9] = initialX + plevra; 
-        vertices[10] = initialY - plevra;
-        
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
         
         glUseProgram(shaderProgram);
 
@@ -160,14 +180,123 @@ void cursor_pos_callback(GLFWwindow* window, double xpos, double ypos)
   
 }
 
+// Scene entry points, used by main below and by scene_host.cpp
+void SceneInit(int width, int height, unsigned int seed)
+{
+    gen.seed(seed);
+    PlaceSquare();
+    Wwidth0 = width;
+    Wheight0 = height;
+    InitMyShaders();
+    SetupVerticesData();
+    myInit(); 
+    if (onDemand)
+    {
+        damage.windowWidth = width;
+        damage.windowHeight = height;
+        if (InitRetainedFrame(retained, width, height))
+            MarkAllDirty(damage);
+        else
+            onDemand = false;
+    }
+}
+
+void SceneFrame(double /*time*/) // the square only moves on input
+{
+    // state other scenes in the same context may have changed
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glClearColor(0.2, 0.2, 0.3, 0.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    glUseProgram(shaderProgram);
 
+    // stream this frame's copy of the square; StreamAlloc aligns the offset to the stride
+    BeginStreamFrame(streamVBO);
+    GLintptr offset = StreamUpload(streamVBO, vertices, sizeof(vertices), PositionLayout::stride);
+
+    glBindVertexArray(VAO);
+    if (offset >= 0)
+        glDrawArrays(GL_QUADS, (GLint)(offset / PositionLayout::stride), 4);
+    HudCountDraws(1);
+    EndStreamFrame(streamVBO);
+}
+
+// --on-demand frame: clears and redraws the dirty rects of the retained frame and presents it.
+void SceneRedrawDirty()
+{
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glClearColor(0.2, 0.2, 0.3, 0.0);
+    glUseProgram(shaderProgram);
+
+    BeginStreamFrame(streamVBO);
+    GLintptr offset = StreamUpload(streamVBO, vertices, sizeof(vertices), PositionLayout::stride);
+    glBindVertexArray(VAO);
+    BeginDirtyRedraw(retained);
+    for (const DirtyRect& rect : damage.rects)
+    {
+        ScissorDirtyRect(rect);
+        glClear(GL_COLOR_BUFFER_BIT);
+        if (offset >= 0)
+            glDrawArrays(GL_QUADS, (GLint)(offset / PositionLayout::stride), 4);
+    }
+    HudCountDraws((unsigned int)damage.rects.size());
+    PresentRetainedFrame(retained);
+    EndStreamFrame(streamVBO);
+    ClearDirty(damage);
+}
+
+void SceneShutdown()
+{
+    if (onDemand)
+    {
+        printf("square damage: %.2f%% of the pixels of full redraws\n",
+               damage.pixelsFull ? 100.0 * damage.pixelsRedrawn / damage.pixelsFull : 0.0);
+        DestroyRetainedFrame(retained);
+    }
+    PrintStreamStats(streamVBO, "square stream");
+    DestroyStreamBuffer(streamVBO);
+    DeleteGLObjects(GL_VERTEX_ARRAY, 1, &VAO);
+    ReleaseProgram(shaderProgram);
+}
+
+} // namespace square
+
+#ifndef SCENE_HOST
+int main(int argc, char** argv) {
+    using namespace square;
+    const char* capturePath = NULL;
+    double dynresTarget = 0.0; // ms, 0 = off
+    const char* dynresLog = NULL;
+    bool hud = false;
+    bool checkHeap = false; // --heap-check: steady-state frames must not allocate
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+            capturePath = argv[++i];
+        else if (strcmp(argv[i], "--hud") == 0)
+            hud = true;
+        else if (strcmp(argv[i], "--heap-check") == 0)
+            checkHeap = true;
+        else if (strcmp(argv[i], "--on-demand") == 0)
+            onDemand = true;
+        else if (strcmp(argv[i], "--dynres") == 0 && i + 1 < argc)
+        {
+            dynresTarget = atof(argv[++i]);
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                dynresLog = argv[++i];
+        }
+    }
 
-    
-int main(void) {
     if (!glfwInit()) {
         fprintf(stderr, "ERROR: could not start GLFW3\n");
         return 1;
     }
+    if (!InitInputRecorder(recorder, argc, argv)) {
+        glfwTerminate();
+        return 1;
+    }
 
     GLFWwindow* window = glfwCreateWindow(800, 800, "My Practice APP", NULL, NULL);
     if (!window) {
@@ -177,7 +306,7 @@ int main(void) {
     }
     glfwMakeContextCurrent(window);
 
-    glfwSetCursorPosCallback(window, cursor_pos_callback);
+    SetInputCursorCallback(recorder, window, cursor_pos_callback);
 
     glewInit();
 
@@ -186,26 +315,79 @@ int main(void) {
     printf("Renderer: %s\n", renderer);
     printf("OpenGL version supported %s\n", version);
 
-    glfwGetWindowSize(window, &Wwidth0, &Wheight0); 
-    printf("winow size %d x %d \n", Wwidth0, Wheight0);
+    int width, height;
+    glfwGetWindowSize(window, &width, &height); 
+    printf("winow size %d x %d \n", width, height);
 
-    InitMyShaders();
-    SetupVerticesData();
-    myInit(); 
+    SceneInit(width, height, (unsigned int)recorder.seed);
+    FrameCapture capture;
+    if (capturePath && !InitFrameCapture(capture, capturePath, width, height))
+        return 1;
+    if (onDemand && dynresTarget > 0.0)
+    {
+        fprintf(stderr, "--dynres does not apply to --on-demand, ignored\n");
+        dynresTarget = 0.0;
+    }
+    DynamicResolution dynres;
+    if (dynresTarget > 0.0 && !InitDynamicResolution(dynres, width, height, dynresTarget, dynresLog))
+        return 1;
+    if (hud && !InitPerfHud(width, height))
+        return 1;
+    PrintGLTotals("after init");
 
+    RenderLoad load;
+    InitRenderLoad(load);
+    if (checkHeap)
+        BeginHeapCheck();
     while (!glfwWindowShouldClose(window))
     {
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        glUseProgram(shaderProgram);
-
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_QUADS, 0, 4);
-
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        unsigned int eventsBefore = inputEvents;
+        double time = BeginInputFrame(recorder);
+        bool rendered = true;
+        if (onDemand)
+        {
+            // nothing changed: block until input (or the timeout, so idle time is still counted)
+            rendered = IsDirty(damage);
+            if (rendered)
+            {
+                BeginHudFrame();
+                BeginHudScope("scene");
+                SceneRedrawDirty();
+                EndHudScope();
+                DrawHud(); // over the window only; the retained frame stays clean
+                CaptureFrame(capture);
+                glfwSwapBuffers(window);
+            }
+            PollInput(recorder, window, IsDirty(damage) ? 0.0 : kIdleWaitSeconds);
+        }
+        else
+        {
+            BeginHudFrame();
+            if (dynres.enabled)
+                BeginDynamicResolution(dynres);
+            BeginHudScope("scene");
+            SceneFrame(time);
+            EndHudScope();
+            if (dynres.enabled)
+                EndDynamicResolution(dynres);
+            DrawHud();
+            CaptureFrame(capture);
+
+            glfwSwapBuffers(window);
+            PollInput(recorder, window);
+        }
+        CountRenderLoad(load, inputEvents != eventsBefore, rendered);
+        CountFrameHeap();
     }
-
+    PrintRenderLoad(load, onDemand ? "on-demand" : "continuous");
+
+    FinishFrameCapture(capture);
+    DestroyDynamicResolution(dynres);
+    DestroyPerfHud();
+    CloseInputRecorder(recorder);
+    SceneShutdown();
+    ReportGLLeaks();
     glfwTerminate();
-    return 0;
+    return EndHeapCheck() ? 0 : 1;
 }
+#endif